@@ -0,0 +1,113 @@
+#include <chrono>
+#include <cstdio>
+#include <numeric>
+#include <vector>
+#include <glm/mat4x4.hpp> // glm::mat4
+#include <glm/gtc/matrix_transform.hpp>
+#include "../src/culling/FrustumCuller.h"
+
+/**
+ * Compares the per-tile frustum culling (Tile::isInViewFrustum) with the batched
+ * kernels of FrustumCuller on the grid of the finest level of detail (128x64 tiles).
+ */
+
+static const int numTilesLongitude = 128;
+static const int numTilesLatitude = 64;
+static const int numRepetitions = 200;
+
+static std::vector<Tile> createTileGrid(Ellipsoid &ellipsoid) {
+    std::vector<Tile> tiles;
+    double tileWidth = 360.0 / numTilesLongitude;
+    double tileHeight = 180.0 / numTilesLatitude;
+    for (int latIndex = 0; latIndex < numTilesLatitude; latIndex++) {
+        for (int lonIndex = 0; lonIndex < numTilesLongitude; lonIndex++) {
+            tiles.emplace_back(latIndex * tileHeight - 90.0, lonIndex * tileWidth - 180.0, tileHeight, tileWidth);
+        }
+    }
+    for (Tile &tile: tiles) {
+        tile.updateGeocentricPosition(ellipsoid);
+    }
+    return tiles;
+}
+
+static Frustum createFrustum(const glm::vec3 &cameraPosition) {
+    glm::mat4 view = glm::lookAt(cameraPosition, glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.01f, 10.0f);
+    return Frustum(view, projection);
+}
+
+/**
+ * Runs the given culling function repeatedly and returns the average time in microseconds.
+ */
+template<typename Function>
+static double measure(Function cull) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < numRepetitions; i++) {
+        cull();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / numRepetitions;
+}
+
+static size_t countVisible(const std::vector<uint8_t> &visibilityMask, size_t numTiles) {
+    size_t numVisible = 0;
+    for (size_t i = 0; i < numTiles; i++) {
+        numVisible += FrustumCuller::isVisible(visibilityMask, i);
+    }
+    return numVisible;
+}
+
+int main() {
+    Ellipsoid ellipsoid = Ellipsoid::unitSphere();
+    std::vector<Tile> tiles = createTileGrid(ellipsoid);
+    TileBounds bounds;
+    bounds.build(tiles);
+
+    std::vector<unsigned int> tileIndices(tiles.size());
+    std::iota(tileIndices.begin(), tileIndices.end(), 0);
+
+    std::vector<glm::vec3> cameraPositions = {
+            glm::vec3(3, 0, 0),
+            glm::vec3(0, 1.5, 1.5),
+            glm::vec3(-1.05, 0.1, 0.2)
+    };
+
+    std::printf("Tiles: %zu, kernel: %s, repetitions: %d\n",
+                tiles.size(), FrustumCuller::getInstructionSet(), numRepetitions);
+    std::printf("%-22s %12s %12s %12s %10s\n", "camera", "per-tile us", "range us", "indexed us", "speedup");
+
+    for (const auto &cameraPosition: cameraPositions) {
+        Frustum frustum = createFrustum(cameraPosition);
+        FrustumCuller culler(frustum);
+
+        std::vector<uint8_t> perTileMask((tiles.size() + 7) / 8);
+        double perTileTime = measure([&]() {
+            for (size_t i = 0; i < tiles.size(); i++) {
+                if (tiles[i].isInViewFrustum(frustum)) {
+                    perTileMask[i / 8] |= 1 << (i % 8);
+                }
+            }
+        });
+
+        std::vector<uint8_t> rangeMask;
+        double rangeTime = measure([&]() {
+            culler.cullTileRange(bounds, 0, tiles.size(), rangeMask);
+        });
+
+        std::vector<uint8_t> indexedMask;
+        double indexedTime = measure([&]() {
+            culler.cullTiles(bounds, tileIndices.data(), tileIndices.size(), indexedMask);
+        });
+
+        char cameraName[64];
+        std::snprintf(cameraName, sizeof(cameraName), "(%.2f, %.2f, %.2f)",
+                      cameraPosition.x, cameraPosition.y, cameraPosition.z);
+        std::printf("%-22s %12.1f %12.1f %12.1f %9.1fx\n", cameraName,
+                    perTileTime, rangeTime, indexedTime, perTileTime / rangeTime);
+        std::printf("%-22s %12zu %12zu %12zu\n", "  visible tiles",
+                    countVisible(perTileMask, tiles.size()),
+                    countVisible(rangeMask, tiles.size()),
+                    countVisible(indexedMask, tiles.size()));
+    }
+    return 0;
+}
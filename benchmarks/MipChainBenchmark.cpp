@@ -0,0 +1,54 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "../src/textures/MipChain.h"
+
+/**
+ * Compares the scalar and the vectorized box filter on the mip chain of a tile
+ * of the size used by the texture atlases (480x480 pixels).
+ */
+
+static const int tileWidth = 480;
+static const int numRepetitions = 100;
+
+/**
+ * Runs the given function repeatedly and returns the average time in microseconds.
+ */
+template<typename Function>
+static double measure(Function function) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < numRepetitions; i++) {
+        function();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / numRepetitions;
+}
+
+int main() {
+    int numLevels = MipChain::getNumLevels(tileWidth, tileWidth);
+    std::printf("Tile: %dx%d, levels: %d, kernel: %s, repetitions: %d\n",
+                tileWidth, tileWidth, numLevels, MipChain::getInstructionSet(), numRepetitions);
+    std::printf("%-10s %12s %12s %10s\n", "channels", "scalar us", "vector us", "speedup");
+
+    for (int channels: {1, 3, 4}) {
+        std::vector<unsigned char> chain(MipChain::getChainSize(tileWidth, tileWidth, channels, numLevels));
+        for (size_t i = 0; i < MipChain::getLevelSize(tileWidth, tileWidth, channels, 0); i++) {
+            chain[i] = static_cast<unsigned char>(std::rand() % 256);
+        }
+
+        double scalarTime = measure([&]() {
+            for (int level = 1; level < numLevels; level++) {
+                MipChain::downsampleScalar(
+                        chain.data() + MipChain::getLevelOffset(tileWidth, tileWidth, channels, level - 1),
+                        MipChain::getLevelExtent(tileWidth, level - 1), MipChain::getLevelExtent(tileWidth, level - 1),
+                        channels, chain.data() + MipChain::getLevelOffset(tileWidth, tileWidth, channels, level));
+            }
+        });
+        double vectorTime = measure([&]() {
+            MipChain::build(chain.data(), tileWidth, tileWidth, channels, numLevels);
+        });
+        std::printf("%-10d %12.1f %12.1f %9.2fx\n", channels, scalarTime, vectorTime, scalarTime / vectorTime);
+    }
+    return 0;
+}
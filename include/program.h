@@ -11,14 +11,94 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <memory>
 #include <vector>
+#include <array>
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
 #include "shader.h"
 
+/**
+ * Location of an active uniform as returned by Program::getUniformLocation.
+ * Inactive uniforms have the location -1, which is silently ignored by the setters.
+ */
+using UniformLocation = int;
+
 
 class Program {
 private:
     unsigned int id = 0;
     std::vector<std::unique_ptr<Shader>> shaders;
 
+    /**
+     * The last value set to a uniform. Uniform values are a part of the program's state,
+     * so a value equal to the stored one does not have to be sent to the driver again.
+     */
+    struct UniformValue {
+        bool isSet = false;
+        std::array<unsigned char, sizeof(glm::mat4)> data{};
+    };
+
+    std::unordered_map<std::string, UniformLocation> uniformLocations;
+    std::vector<UniformValue> uniformValues;
+
+    /**
+     * Resolves the locations of all active uniforms of the linked program.
+     */
+    void cacheUniformLocations() {
+        uniformLocations.clear();
+        uniformValues.clear();
+
+        int numUniforms = 0;
+        int maxNameLength = 0;
+        glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &numUniforms);
+        glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+        std::vector<char> nameBuffer(std::max(maxNameLength, 1));
+        for (int index = 0; index < numUniforms; index++) {
+            int nameLength = 0;
+            int size = 0;
+            GLenum type;
+            glGetActiveUniform(id, index, static_cast<int>(nameBuffer.size()), &nameLength, &size, &type,
+                               nameBuffer.data());
+            std::string name(nameBuffer.data(), nameLength);
+
+            // Members of uniform blocks have no location
+            UniformLocation location = glGetUniformLocation(id, name.c_str());
+            if (location < 0) {
+                continue;
+            }
+            uniformLocations[name] = location;
+            // Arrays are reported as "name[0]" but can be referred to by "name" as well
+            auto arraySuffix = name.rfind("[0]");
+            if (arraySuffix != std::string::npos && arraySuffix + 3 == name.size()) {
+                uniformLocations[name.substr(0, arraySuffix)] = location;
+            }
+            if (static_cast<size_t>(location) >= uniformValues.size()) {
+                uniformValues.resize(location + 1);
+            }
+        }
+    }
+
+    /**
+     * Stores the value of the uniform.
+     *
+     * @return True if the value differs from the last one and has to be sent to the driver.
+     */
+    template<typename T>
+    bool updateUniformValue(UniformLocation location, const T &value) {
+        static_assert(sizeof(T) <= sizeof(UniformValue::data), "Unsupported uniform type");
+        if (location < 0 || static_cast<size_t>(location) >= uniformValues.size()) {
+            return false;
+        }
+        UniformValue &cachedValue = uniformValues[location];
+        if (cachedValue.isSet && std::memcmp(cachedValue.data.data(), &value, sizeof(T)) == 0) {
+            return false;
+        }
+        std::memcpy(cachedValue.data.data(), &value, sizeof(T));
+        cachedValue.isSet = true;
+        return true;
+    }
+
     [[nodiscard]] bool printErrorsIfAny() const {
         int success;
         char infoLog[512];
@@ -41,6 +121,7 @@ private:
         }
 
         deleteShaders();
+        cacheUniformLocations();
         return true;
     }
 
@@ -84,32 +165,91 @@ public:
         glUseProgram(id);
     }
 
+    /**
+     * Returns the location of an active uniform, or -1 if the program has no such uniform.
+     * The locations are resolved once after linking, so renderers should look them up once
+     * and use the location-based setters every frame.
+     */
+    [[nodiscard]] UniformLocation getUniformLocation(const std::string &name) const {
+        auto iterator = uniformLocations.find(name);
+        if (iterator == uniformLocations.end()) {
+            return -1;
+        }
+        return iterator->second;
+    }
+
+    /**
+     * Assigns a binding point to a uniform block.
+     *
+     * @return False if the program has no active block of the given name.
+     */
+    bool bindUniformBlock(const std::string &blockName, unsigned int bindingPoint) const {
+        unsigned int blockIndex = glGetUniformBlockIndex(id, blockName.c_str());
+        if (blockIndex == GL_INVALID_INDEX) {
+            return false;
+        }
+        glUniformBlockBinding(id, blockIndex, bindingPoint);
+        return true;
+    }
+
     // utility uniform functions
-    void setBool(const std::string &name, bool value) const {
-        glUniform1i(glGetUniformLocation(id, name.c_str()), (int) value);
+    // The program has to be in use. Values equal to the last set ones are skipped.
+    void setBool(UniformLocation location, bool value) {
+        setInt(location, (int) value);
+    }
+
+    void setInt(UniformLocation location, int value) {
+        if (updateUniformValue(location, value)) {
+            glUniform1i(location, value);
+        }
+    }
+
+    void setFloat(UniformLocation location, float value) {
+        if (updateUniformValue(location, value)) {
+            glUniform1f(location, value);
+        }
+    }
+
+    void setVec3(UniformLocation location, glm::vec3 vec) {
+        if (updateUniformValue(location, vec)) {
+            glUniform3fv(location, 1, glm::value_ptr(vec));
+        }
+    }
+
+    void setVec2(UniformLocation location, glm::vec2 vec) {
+        if (updateUniformValue(location, vec)) {
+            glUniform2fv(location, 1, glm::value_ptr(vec));
+        }
+    }
+
+    void setMat4(UniformLocation location, glm::mat4 matrix) {
+        if (updateUniformValue(location, matrix)) {
+            glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(matrix));
+        }
+    }
+
+    void setBool(const std::string &name, bool value) {
+        setBool(getUniformLocation(name), value);
     }
 
-    void setInt(const std::string &name, int value) const {
-        glUniform1i(glGetUniformLocation(id, name.c_str()), value);
+    void setInt(const std::string &name, int value) {
+        setInt(getUniformLocation(name), value);
     }
 
-    void setFloat(const std::string &name, float value) const {
-        glUniform1f(glGetUniformLocation(id, name.c_str()), value);
+    void setFloat(const std::string &name, float value) {
+        setFloat(getUniformLocation(name), value);
     }
 
-    void setVec3(const std::string &name, glm::vec3 vec) const {
-        int location = glGetUniformLocation(id, name.c_str());
-        glUniform3fv(location, 1, glm::value_ptr(vec));
+    void setVec3(const std::string &name, glm::vec3 vec) {
+        setVec3(getUniformLocation(name), vec);
     }
 
-    void setVec2(const std::string &name, glm::vec2 vec) const {
-        int location = glGetUniformLocation(id, name.c_str());
-        glUniform2fv(location, 1, glm::value_ptr(vec));
+    void setVec2(const std::string &name, glm::vec2 vec) {
+        setVec2(getUniformLocation(name), vec);
     }
 
-    void setMat4(const std::string &name, glm::mat4 matrix) const {
-        int matrixLocation = glGetUniformLocation(id, name.c_str());
-        glUniformMatrix4fv(matrixLocation, 1, GL_FALSE, glm::value_ptr(matrix));
+    void setMat4(const std::string &name, glm::mat4 matrix) {
+        setMat4(getUniformLocation(name), matrix);
     }
 
     ~Program() {
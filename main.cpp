@@ -19,6 +19,7 @@
 #include "src/rendering/TileEarthRenderer.h"
 #include "src/simulation/SolarSimulator.h"
 #include "src/rendering/CityNamesRenderer.h"
+#include "src/rendering/FrameUniformBuffer.h"
 
 #include <glm/vec3.hpp> // glm::vec3
 #include <glm/vec4.hpp> // glm::vec4
@@ -314,11 +315,6 @@ void cleanup(const std::vector<std::shared_ptr<Renderer>> &renderers) {
     glfwTerminate();
 }
 
-void resourceLoaderThreadStart() {
-    ResourceLoader loader;
-    loader.start();
-}
-
 
 /**
  * From:
@@ -415,12 +411,14 @@ void mainAppThread(std::promise<int> &&returnCodePromise) {
     TileContainer tileContainer(tileMeshTesselator, dayMapAtlas,
                                 nightMapAtlas, heightMapAtlas, ellipsoid);
 
+    // Decodes textures on worker threads until the end of this function
     ResourceFetcher resourceFetcher;
-    ResourceManager resourceManager(1000);
+    // 1 GiB of video memory for the textures
+    ResourceManager resourceManager(1024ul * 1024 * 1024);
 
-    dayMapAtlas.registerAvailableTextures("textures/daymaps");
-    nightMapAtlas.registerAvailableTextures("textures/nightmaps");
-    heightMapAtlas.registerAvailableTextures("textures/heightmaps");
+    dayMapAtlas.registerTextures("textures/daymaps");
+    nightMapAtlas.registerTextures("textures/nightmaps");
+    heightMapAtlas.registerTextures("textures/heightmaps");
     tileContainer.setupTiles();
 
     RenderingOptions options = {
@@ -429,6 +427,10 @@ void mainAppThread(std::promise<int> &&returnCodePromise) {
     auto guiRenderer =
             std::make_shared<GuiFrameRenderer>(options, solarSimulator);
 
+    // The frame uniforms are written before any other renderer runs
+    auto frameUniformBuffer = std::make_shared<FrameUniformBuffer>(camera, ellipsoid, solarSimulator);
+    renderers.push_back(frameUniformBuffer);
+
     Program tileEarthRendererProgram;
     tileEarthRendererProgram.addShader(
             std::make_unique<Shader>("shaders/tiling/shader.vert", ShaderType::Vertex)
@@ -444,7 +446,7 @@ void mainAppThread(std::promise<int> &&returnCodePromise) {
     );
     auto tileEarthRenderer =
             std::make_shared<TileEarthRenderer>(
-                    tileContainer, ellipsoid, camera, solarSimulator,
+                    tileContainer, ellipsoid, camera, *frameUniformBuffer,
                     resourceFetcher, resourceManager, tileEarthRendererProgram
             );
     tileEarthRenderer->addSubscriber(guiRenderer);
@@ -458,7 +460,8 @@ void mainAppThread(std::promise<int> &&returnCodePromise) {
             std::make_unique<Shader>("shaders/text/shader.frag", ShaderType::Fragment)
     );
     auto cityNamesRenderer =
-            std::make_shared<CityNamesRenderer>(cityNamesRendererProgram, camera, ellipsoid);
+            std::make_shared<CityNamesRenderer>(cityNamesRendererProgram, camera, ellipsoid,
+                                                *frameUniformBuffer);
     tileEarthRenderer->addSubscriber(cityNamesRenderer);
     renderers.push_back(cityNamesRenderer);
 
@@ -493,21 +496,12 @@ int main() {
     std::cout << "Starting the application..." << std::endl;
     std::cout << "Starting application thread: " << std::this_thread::get_id() << std::endl;
 
-    std::thread loaderThread(resourceLoaderThreadStart);
-
     std::promise<int> p;
     auto futureReturnCode = p.get_future();
     std::thread mainThread(mainAppThread, std::move(p));
 
     mainThread.join();
-    int returnCode = futureReturnCode.get();
-
-    // Stop loader thread
-    stopThread = true;
-    cv.notify_all();
-    loaderThread.join();
-
-    return returnCode;
+    return futureReturnCode.get();
 }
 
 
@@ -3,12 +3,21 @@ layout (location = 0) in vec3 aPos;
 
 out vec3 FragPos;
 
+// Per-frame state shared by all programs, written by FrameUniformBuffer
+layout (std140) uniform FrameUniforms {
+    mat4 view;
+    mat4 projection;
+    vec3 ellipsoidRadiiSquared;
+    vec3 ellipsoidOneOverRadiiSquared;
+    vec3 lightPos;
+};
+
 uniform mat4 model;
-uniform mat4 projection;
-uniform mat4 view;
+// The Sun lies beyond the far plane of the shared projection
+uniform mat4 sunProjection;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = sunProjection * view * model * vec4(aPos, 1.0);
     FragPos = aPos;
 }
\ No newline at end of file
@@ -5,10 +5,14 @@ layout (location = 1) in vec2 instancePosition;
 
 out vec2 TexCoords;
 
-uniform mat4 view;
-uniform mat4 projection;
-
-uniform vec3 ellipsoidRadiiSquared;
+// Per-frame state shared by all programs, written by FrameUniformBuffer
+layout (std140) uniform FrameUniforms {
+    mat4 view;
+    mat4 projection;
+    vec3 ellipsoidRadiiSquared;
+    vec3 ellipsoidOneOverRadiiSquared;
+    vec3 lightPos;
+};
 
 vec3 convertGeographicToGeodeticSurfaceNormal(vec3 geographic) {
     float longitude = geographic.x;
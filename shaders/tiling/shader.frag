@@ -4,36 +4,35 @@
 in TE_OUT {
     vec3 geocentricFragPos;
     vec3 surfaceNormal;
+    flat vec4 dayTexture;
+    flat vec4 nightTexture;
+    flat vec4 heightMap;
+    flat vec3 textureLayers;
 } fs_in;
 
 out vec4 FragColor;
 
-// Lighting
-uniform vec3 lightPos;
+// Per-frame state shared by all programs, written by FrameUniformBuffer
+layout (std140) uniform FrameUniforms {
+    mat4 view;
+    mat4 projection;
+    vec3 ellipsoidRadiiSquared;
+    vec3 ellipsoidOneOverRadiiSquared;
+    vec3 lightPos;
+};
 
 // Textures
-uniform sampler2D dayTextureSampler;
-uniform vec2 dayTextureGeodeticOffset; // In radians
-uniform vec2 dayTextureGridSize;
-
-uniform sampler2D nightTextureSampler;
-uniform vec2 nightTextureGeodeticOffset; // In radians
-uniform vec2 nightTextureGridSize;
+uniform sampler2DArray dayTextureSampler;
+uniform sampler2DArray nightTextureSampler;
 
 // Height map
-uniform sampler2D heightMapSampler;
-uniform vec2 heightMapGeodeticOffset; // In radians
-uniform vec2 heightMapGridSize;
+uniform sampler2DArray heightMapSampler;
 uniform float heightDisplacementFactor;
 uniform int heightScale;
 
 uniform float blendDuration;
 uniform float blendDurationScale;
 
-// Ellipsoid definition
-uniform vec3 ellipsoidRadiiSquared;
-uniform vec3 ellipsoidOneOverRadiiSquared;
-
 // Grid definition
 uniform float gridResolution;
 uniform float gridLineWidth;
@@ -72,37 +71,28 @@ float computeLightIntensity(float diffuseIntensity)
     return intensity;
 }
 
-vec2 calcTileDayTextureCoordinates(vec2 globalTextureCoordinates) {
-    // Use the following direct approach to handle the problem with the poles
-    float normalizedLongitude = (dayTextureGeodeticOffset[0] + PI) / (2.0 * PI);
-    float normalizedLatitude = (dayTextureGeodeticOffset[1] + PI / 2.0) / PI;
-    vec2 textureCoordinatesOffset = vec2(normalizedLongitude, normalizedLatitude);
-
-    vec2 tileTextureCoordinates = (globalTextureCoordinates - textureCoordinatesOffset) * dayTextureGridSize;
-    return tileTextureCoordinates;
-}
-
-vec2 calcTileNightTextureCoordinates(vec2 globalTextureCoordinates) {
+// The texture is given by its geodetic offset in radians (xy) and the size of its grid (zw)
+vec2 calcTileTextureCoordinates(vec2 globalTextureCoordinates, vec4 tileTexture) {
     // Use the following direct approach to handle the problem with the poles
-    float normalizedLongitude = (nightTextureGeodeticOffset[0] + PI) / (2.0 * PI);
-    float normalizedLatitude = (nightTextureGeodeticOffset[1] + PI / 2.0) / PI;
+    float normalizedLongitude = (tileTexture.x + PI) / (2.0 * PI);
+    float normalizedLatitude = (tileTexture.y + PI / 2.0) / PI;
     vec2 textureCoordinatesOffset = vec2(normalizedLongitude, normalizedLatitude);
 
-    vec2 tileTextureCoordinates = (globalTextureCoordinates - textureCoordinatesOffset) * nightTextureGridSize;
+    vec2 tileTextureCoordinates = (globalTextureCoordinates - textureCoordinatesOffset) * tileTexture.zw;
     return tileTextureCoordinates;
 }
 
 vec4 computeDayColor(vec2 globalTextureCoordinates, float diffuseStrength)
 {
-    vec2 tileTextureCoordinates = calcTileDayTextureCoordinates(globalTextureCoordinates);
+    vec2 tileTextureCoordinates = calcTileTextureCoordinates(globalTextureCoordinates, fs_in.dayTexture);
     float lightIntensity = computeLightIntensity(diffuseStrength);
-    return lightIntensity * texture(dayTextureSampler, tileTextureCoordinates);
+    return lightIntensity * texture(dayTextureSampler, vec3(tileTextureCoordinates, fs_in.textureLayers.x));
 }
 
 vec4 computeNightColor(vec2 globalTextureCoordinates)
 {
-    vec2 tileTextureCoordinates = calcTileNightTextureCoordinates(globalTextureCoordinates);
-    return texture(nightTextureSampler, tileTextureCoordinates);
+    vec2 tileTextureCoordinates = calcTileTextureCoordinates(globalTextureCoordinates, fs_in.nightTexture);
+    return texture(nightTextureSampler, vec3(tileTextureCoordinates, fs_in.textureLayers.y));
 }
 
 vec2 computeTextureCoordinates(vec3 normal)
@@ -182,28 +172,17 @@ mat3 construct_tbn_matrix(vec3 surfaceNormal, vec3 worldPosition, vec2 textureCo
     return tbn;
 }
 
-vec2 calcTileHeightTextureCoordinates(vec2 globalTextureCoordinates) {
-    // Use the following direct approach to handle the problem with the poles
-    float normalizedLongitude = (heightMapGeodeticOffset[0] + PI) / (2.0 * PI);
-    float normalizedLatitude = (heightMapGeodeticOffset[1] + PI / 2.0) / PI;
-    vec2 textureCoordinatesOffset = vec2(normalizedLongitude, normalizedLatitude);
-
-    vec2 tileTextureCoordinates = (globalTextureCoordinates - textureCoordinatesOffset) * heightMapGridSize;
-    return tileTextureCoordinates;
-}
-
-
-vec2 computeNormalSobelFilter(vec2 position, sampler2D heightMap) {
+vec2 computeNormalSobelFilter(vec2 position, sampler2DArray heightMap, float layer) {
     float coeff = 1.0 / 255.0;
-    vec2 tileTextureSize = textureSize(heightMap, 0);
-    float upperLeft = texture(heightMap, position.xy + vec2(-1.0, 1.0) / tileTextureSize).r * coeff;
-    float upperCenter = texture(heightMap, position.xy + vec2(0.0, 1.0) / tileTextureSize).r * coeff;
-    float upperRight = texture(heightMap, position.xy + vec2(1.0, 1.0) / tileTextureSize).r * coeff;
-    float left = texture(heightMap, position.xy + vec2(-1.0, 0.0) / tileTextureSize).r * coeff;
-    float right = texture(heightMap, position.xy + vec2(1.0, 0.0) / tileTextureSize).r * coeff;
-    float lowerLeft = texture(heightMap, position.xy + vec2(-1.0, -1.0) / tileTextureSize).r * coeff;
-    float lowerCenter = texture(heightMap, position.xy + vec2(0.0, -1.0) / tileTextureSize).r * coeff;
-    float lowerRight = texture(heightMap, position.xy + vec2(1.0, -1.0) / tileTextureSize).r * coeff;
+    vec2 tileTextureSize = textureSize(heightMap, 0).xy;
+    float upperLeft = texture(heightMap, vec3(position.xy + vec2(-1.0, 1.0) / tileTextureSize, layer)).r * coeff;
+    float upperCenter = texture(heightMap, vec3(position.xy + vec2(0.0, 1.0) / tileTextureSize, layer)).r * coeff;
+    float upperRight = texture(heightMap, vec3(position.xy + vec2(1.0, 1.0) / tileTextureSize, layer)).r * coeff;
+    float left = texture(heightMap, vec3(position.xy + vec2(-1.0, 0.0) / tileTextureSize, layer)).r * coeff;
+    float right = texture(heightMap, vec3(position.xy + vec2(1.0, 0.0) / tileTextureSize, layer)).r * coeff;
+    float lowerLeft = texture(heightMap, vec3(position.xy + vec2(-1.0, -1.0) / tileTextureSize, layer)).r * coeff;
+    float lowerCenter = texture(heightMap, vec3(position.xy + vec2(0.0, -1.0) / tileTextureSize, layer)).r * coeff;
+    float lowerRight = texture(heightMap, vec3(position.xy + vec2(1.0, -1.0) / tileTextureSize, layer)).r * coeff;
 
     float x = upperRight + (2.0 * right) + lowerRight -
     upperLeft - (2.0 * left) - lowerLeft;
@@ -230,8 +209,8 @@ void main()
             vec3 normal = fs_in.surfaceNormal;
             if (isTerrainShadingEnabled) {
                 mat3 tbn = construct_tbn_matrix(normal, fs_in.geocentricFragPos, globalTextureCoordinates);
-                vec2 heightMapTextureCoords = calcTileHeightTextureCoordinates(globalTextureCoordinates);
-                vec2 gradient = computeNormalSobelFilter(heightMapTextureCoords, heightMapSampler);
+                vec2 heightMapTextureCoords = calcTileTextureCoordinates(globalTextureCoordinates, fs_in.heightMap);
+                vec2 gradient = computeNormalSobelFilter(heightMapTextureCoords, heightMapSampler, fs_in.textureLayers.z);
                 vec3 geometryNormal = normalize(vec3(gradient * heightScale, 1.0));
                 vec3 normal = tbn * geometryNormal;
 
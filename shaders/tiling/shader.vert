@@ -1,21 +1,54 @@
 #version 400 core
 // Offset of the vertex within the tile in longitude and latitude
-// in the [0, 1] range.
-layout (location = 0) in vec3 aPos;
+// in the [0, 1] range. Unused if the grid is procedural.
+layout (location = 0) in vec2 aPos;
+// Per-instance attributes
+// Longitude offset, latitude offset, longitude width, and latitude width of the tile in degrees
+layout (location = 1) in vec4 aTileBounds;
+// Geodetic offset (in radians) and grid size of the textures
+layout (location = 2) in vec4 aDayTexture;
+layout (location = 3) in vec4 aNightTexture;
+layout (location = 4) in vec4 aHeightMap;
+// Layers of the day, night, and height texture arrays
+layout (location = 5) in vec3 aTextureLayers;
 
 out VS_OUT {
     vec3 geocentricFragPos;
     vec3 surfaceNormal;
+    vec4 dayTexture;
+    vec4 nightTexture;
+    vec4 heightMap;
+    vec3 textureLayers;
 } vs_out;
 
-uniform vec3 ellipsoidRadiiSquared;
+// Per-frame state shared by all programs, written by FrameUniformBuffer
+layout (std140) uniform FrameUniforms {
+    mat4 view;
+    mat4 projection;
+    vec3 ellipsoidRadiiSquared;
+    vec3 ellipsoidOneOverRadiiSquared;
+    vec3 lightPos;
+};
 
-uniform float uTileLongitudeOffset;
-uniform float uTileLatitudeOffset;
-uniform float uTileLongitudeWidth;
-uniform float uTileLatitudeWidth;
+// Generate the grid from gl_VertexID instead of reading the vertex attribute
+uniform bool useProceduralGrid;
+// The number of quads of the grid in longitude and latitude
+uniform vec2 meshGridResolution;
 
-uniform vec3 ellipsoidOneOverRadiiSquared;
+// Corners of the two triangles of each quad of the grid, in the order of TileMeshTesselator
+const vec2 quadCorners[6] = vec2[6](
+    vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(0.0, 1.0),
+    vec2(1.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0));
+
+vec2 getGridPosition() {
+    if (!useProceduralGrid) {
+        return aPos;
+    }
+    int numColumns = int(meshGridResolution.x);
+    int quad = gl_VertexID / 6;
+    vec2 quadPosition = vec2(quad % numColumns, quad / numColumns);
+    return (quadPosition + quadCorners[gl_VertexID % 6]) / meshGridResolution;
+}
 
 vec3 convertGeocentricToGeocentricSurfaceNormal(vec3 point)
 {
@@ -50,8 +83,9 @@ vec3 convertGeodeticToGeocentric(vec3 geodetic) {
 
 void main()
 {
-    float longitude = uTileLongitudeOffset + aPos.x * uTileLongitudeWidth;
-    float latitude = uTileLatitudeOffset + aPos.y * uTileLatitudeWidth;
+    vec2 gridPosition = getGridPosition();
+    float longitude = aTileBounds.x + gridPosition.x * aTileBounds.z;
+    float latitude = aTileBounds.y + gridPosition.y * aTileBounds.w;
 
     longitude = radians(longitude);
     latitude = radians(latitude);
@@ -63,4 +97,8 @@ void main()
     gl_Position = vec4(geocentricCoordinates, 1.0);
     vs_out.geocentricFragPos = geocentricCoordinates;
     vs_out.surfaceNormal = surfaceNormal;
+    vs_out.dayTexture = aDayTexture;
+    vs_out.nightTexture = aNightTexture;
+    vs_out.heightMap = aHeightMap;
+    vs_out.textureLayers = aTextureLayers;
 }
\ No newline at end of file
@@ -1,5 +1,8 @@
 
 #include "Frustum.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 Frustum::Frustum(const glm::mat4 viewMatrix, const glm::mat4 projectionMatrix) {
     glm::mat4 viewProjectionMatrix = projectionMatrix * viewMatrix;
@@ -14,6 +17,11 @@ Frustum::Frustum(const glm::mat4 viewMatrix, const glm::mat4 projectionMatrix) {
         planes[4][i] = viewProjectionMatrix[i][3] + viewProjectionMatrix[i][2];  // Near
         planes[5][i] = viewProjectionMatrix[i][3] - viewProjectionMatrix[i][2];  // Far
     }
+
+    // Normalize the planes so that the signed distances are in world units.
+    for (auto &plane: planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
 }
 
 [[nodiscard]] bool Frustum::isPointOutside(glm::vec3 geocentricPoint) const {
@@ -37,4 +45,35 @@ Frustum::Frustum(const glm::mat4 viewMatrix, const glm::mat4 projectionMatrix) {
         }
     }
     return false;
-}
\ No newline at end of file
+}
+
+[[nodiscard]] bool Frustum::isSphereOutside(glm::vec3 centre, float radius) const {
+    for (auto plane : planes) {
+        float signedDistance = glm::dot(plane, glm::vec4(centre, 1.0));
+
+        if (signedDistance < -radius) {
+            return true;
+        }
+    }
+    return false;
+}
+
+[[nodiscard]] bool Frustum::isSphereInside(glm::vec3 centre, float radius) const {
+    for (auto plane : planes) {
+        float signedDistance = glm::dot(plane, glm::vec4(centre, 1.0));
+
+        if (signedDistance <= radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+[[nodiscard]] float Frustum::getSphereMargin(glm::vec3 centre, float radius) const {
+    float margin = std::numeric_limits<float>::infinity();
+    for (auto plane : planes) {
+        float signedDistance = glm::dot(plane, glm::vec4(centre, 1.0));
+        margin = std::min(margin, std::abs(signedDistance) - radius);
+    }
+    return std::max(margin, 0.0f);
+}
@@ -14,14 +14,39 @@
 
 class Frustum {
 public:
+    static const int numPlanes = 6;
+
     explicit Frustum(const glm::mat4 viewMatrix, const glm::mat4 projectionMatrix);
 
     [[nodiscard]] bool isPointOutside(glm::vec3 geocentricPoint) const;
 
     [[nodiscard]] bool intersectsEdge(std::pair<glm::vec3, glm::vec3> edge) const;
 
+    /**
+     * The sphere is completely outside of at least one plane.
+     */
+    [[nodiscard]] bool isSphereOutside(glm::vec3 centre, float radius) const;
+
+    /**
+     * The sphere is completely inside of all planes.
+     */
+    [[nodiscard]] bool isSphereInside(glm::vec3 centre, float radius) const;
+
+    /**
+     * The distance by which the planes may move before the sphere touches any of them.
+     * Zero if the sphere already intersects a plane.
+     */
+    [[nodiscard]] float getSphereMargin(glm::vec3 centre, float radius) const;
+
+    /**
+     * Returns the plane (a, b, c, d) with a normalized normal (a, b, c) pointing
+     * inside the frustum. The signed distance of a point is then a*x + b*y + c*z + d.
+     */
+    [[nodiscard]] const glm::vec4 &getPlane(int index) const {
+        return planes[index];
+    }
+
 private:
-    static const int numPlanes = 6;
     glm::vec4 planes[numPlanes];
 };
 
@@ -0,0 +1,53 @@
+#include "EllipsoidalOccluder.h"
+#include <algorithm>
+#include <cmath>
+
+EllipsoidalOccluder::EllipsoidalOccluder(const Ellipsoid &ellipsoid, const glm::vec3 &cameraPosition) {
+    oneOverRadii = 1.0f / ellipsoid.getRadii();
+    scaledCameraPosition = cameraPosition * oneOverRadii;
+    horizonDistanceSquared = glm::dot(scaledCameraPosition, scaledCameraPosition) - 1.0f;
+}
+
+bool EllipsoidalOccluder::isScaledSpacePointVisible(const glm::vec3 &occludeePoint) const {
+    // The camera is inside the ellipsoid, there is no horizon
+    if (horizonDistanceSquared <= 0) {
+        return true;
+    }
+    // The point is occluded if it is behind the plane of the horizon
+    // and inside the cone formed by the camera and the horizon.
+    glm::vec3 cameraToPoint = occludeePoint - scaledCameraPosition;
+    float projectedDistance = -glm::dot(cameraToPoint, scaledCameraPosition);
+    bool isOccluded = projectedDistance > horizonDistanceSquared &&
+                      projectedDistance * projectedDistance / glm::dot(cameraToPoint, cameraToPoint) >
+                      horizonDistanceSquared;
+    return !isOccluded;
+}
+
+bool EllipsoidalOccluder::computeOccludeePoint(const Ellipsoid &ellipsoid, const glm::vec3 &direction,
+                                               const glm::vec3 *points, int numPoints,
+                                               glm::vec3 &occludeePoint) {
+    glm::vec3 oneOverRadii = 1.0f / ellipsoid.getRadii();
+    glm::vec3 scaledDirection = glm::normalize(direction * oneOverRadii);
+
+    double maxMagnitude = 0;
+    for (int i = 0; i < numPoints; i++) {
+        glm::vec3 scaledPoint = points[i] * oneOverRadii;
+        double magnitude = std::max(static_cast<double>(glm::length(scaledPoint)), 1.0);
+        glm::vec3 pointDirection = glm::normalize(scaledPoint);
+
+        // Angle between the point and the direction (alpha), and between the point
+        // and the tangent from the point to the unit sphere (beta).
+        double cosAlpha = glm::dot(pointDirection, scaledDirection);
+        double sinAlpha = glm::length(glm::cross(pointDirection, scaledDirection));
+        double cosBeta = 1.0 / magnitude;
+        double sinBeta = std::sqrt(magnitude * magnitude - 1.0) * cosBeta;
+
+        double denominator = cosAlpha * cosBeta - sinAlpha * sinBeta;
+        if (denominator <= 0) {
+            return false;
+        }
+        maxMagnitude = std::max(maxMagnitude, 1.0 / denominator);
+    }
+    occludeePoint = scaledDirection * static_cast<float>(maxMagnitude);
+    return true;
+}
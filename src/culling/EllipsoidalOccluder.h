@@ -0,0 +1,45 @@
+#ifndef EARTH_VISUALIZATION_ELLIPSOIDALOCCLUDER_H
+#define EARTH_VISUALIZATION_ELLIPSOIDALOCCLUDER_H
+
+#include <glm/vec3.hpp>
+#include "../ellipsoid.h"
+
+/**
+ * Horizon culling against the ellipsoid, as described in the book:
+ * "P. Cozzi, K. Ring, 3D Engine Design for Virtual Globes. A. K. Peters, Ltd., 2011."
+ *
+ * The test works in the scaled space, in which the ellipsoid becomes a unit sphere.
+ * Each tile is represented by a single occludee point. If the occludee point is below
+ * the horizon as seen from the camera, the whole tile is below the horizon.
+ */
+class EllipsoidalOccluder {
+private:
+    glm::vec3 oneOverRadii;
+    glm::vec3 scaledCameraPosition;
+    // Squared distance from the camera to the horizon in the scaled space.
+    float horizonDistanceSquared;
+
+public:
+    EllipsoidalOccluder(const Ellipsoid &ellipsoid, const glm::vec3 &cameraPosition);
+
+    /**
+     * Checks whether the occludee point (in the scaled space) can be seen from the camera.
+     */
+    [[nodiscard]] bool isScaledSpacePointVisible(const glm::vec3 &occludeePoint) const;
+
+    /**
+     * Computes the occludee point of a set of points on or above the ellipsoid.
+     * The occludee point lies in the given direction from the centre, far enough
+     * for all the points to be below the horizon whenever the occludee point is.
+     *
+     * @param direction The direction in the geocentric space, typically towards the centre of the points.
+     * @param occludeePoint The resulting point in the scaled space.
+     * @return False if no such point exists, i.e., the points span more than a hemisphere.
+     */
+    static bool computeOccludeePoint(const Ellipsoid &ellipsoid, const glm::vec3 &direction,
+                                     const glm::vec3 *points, int numPoints,
+                                     glm::vec3 &occludeePoint);
+};
+
+
+#endif //EARTH_VISUALIZATION_ELLIPSOIDALOCCLUDER_H
@@ -0,0 +1,321 @@
+#include "FrustumCuller.h"
+#include <algorithm>
+#include <limits>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define FRUSTUM_CULLER_AVX
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define FRUSTUM_CULLER_SSE
+#endif
+
+namespace {
+    using Planes = float[Frustum::numPlanes][4];
+
+    /**
+     * A batch of tiles stored next to each other.
+     */
+    struct RangeBatch {
+        unsigned int firstTile;
+
+        [[nodiscard]] unsigned int getTileIndex(int lane) const {
+            return firstTile + lane;
+        }
+
+        [[nodiscard]] RangeBatch offset(int lanes) const {
+            return {firstTile + lanes};
+        }
+    };
+
+    /**
+     * A batch of tiles with arbitrary indices.
+     */
+    struct IndexedBatch {
+        const unsigned int *tileIndices;
+
+        [[nodiscard]] unsigned int getTileIndex(int lane) const {
+            return tileIndices[lane];
+        }
+
+        [[nodiscard]] IndexedBatch offset(int lanes) const {
+            return {tileIndices + lanes};
+        }
+    };
+
+    /**
+     * The order of operations matches the SIMD kernels so that all paths give the same results.
+     */
+    inline float computeSignedDistance(const float plane[4], float x, float y, float z) {
+        return (x * plane[0] + y * plane[1]) + (z * plane[2] + plane[3]);
+    }
+
+    bool isTileVisibleScalar(const Planes &planes, const TileBounds &bounds, unsigned int tileIndex) {
+        // Bounding-sphere pre-test
+        float radius = bounds.getSphereRadius()[tileIndex];
+        bool isSphereInside = true;
+        for (const auto &plane: planes) {
+            float distance = computeSignedDistance(plane,
+                                                   bounds.getSphereX()[tileIndex],
+                                                   bounds.getSphereY()[tileIndex],
+                                                   bounds.getSphereZ()[tileIndex]);
+            if (distance < -radius) {
+                return false;
+            }
+            isSphereInside &= distance > radius;
+        }
+        if (isSphereInside) {
+            return true;
+        }
+
+        float negativeSlack = -bounds.getSlack()[tileIndex];
+        for (const auto &plane: planes) {
+            float maxDistance = -std::numeric_limits<float>::infinity();
+            for (int point = 0; point < TileBounds::numPoints; point++) {
+                float distance = computeSignedDistance(plane,
+                                                       bounds.getX(point)[tileIndex],
+                                                       bounds.getY(point)[tileIndex],
+                                                       bounds.getZ(point)[tileIndex]);
+                maxDistance = std::max(maxDistance, distance);
+            }
+            // All points are outside this plane
+            if (maxDistance < negativeSlack) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+#if defined(FRUSTUM_CULLER_AVX)
+
+    inline __m256 load(const float *values, const RangeBatch &batch) {
+        return _mm256_loadu_ps(values + batch.firstTile);
+    }
+
+    inline __m256 load(const float *values, const IndexedBatch &batch) {
+#if defined(__AVX2__)
+        __m256i indices = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(batch.tileIndices));
+        return _mm256_i32gather_ps(values, indices, sizeof(float));
+#else
+        const unsigned int *i = batch.tileIndices;
+        return _mm256_setr_ps(values[i[0]], values[i[1]], values[i[2]], values[i[3]],
+                              values[i[4]], values[i[5]], values[i[6]], values[i[7]]);
+#endif
+    }
+
+    inline __m256 computeSignedDistance(const float plane[4], __m256 x, __m256 y, __m256 z) {
+        __m256 xy = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(plane[0])),
+                                  _mm256_mul_ps(y, _mm256_set1_ps(plane[1])));
+        __m256 zw = _mm256_add_ps(_mm256_mul_ps(z, _mm256_set1_ps(plane[2])),
+                                  _mm256_set1_ps(plane[3]));
+        return _mm256_add_ps(xy, zw);
+    }
+
+    template<typename Batch>
+    uint8_t classifyBatch(const Planes &planes, const TileBounds &bounds, const Batch &batch) {
+        // Bounding-sphere pre-test. The sample points are tested only if some
+        // of the spheres intersect the frustum.
+        __m256 sphereX = load(bounds.getSphereX(), batch);
+        __m256 sphereY = load(bounds.getSphereY(), batch);
+        __m256 sphereZ = load(bounds.getSphereZ(), batch);
+        __m256 radius = load(bounds.getSphereRadius(), batch);
+        __m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), radius);
+        __m256 sphereOutside = _mm256_setzero_ps();
+        __m256 sphereInside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (const auto &plane: planes) {
+            __m256 distance = computeSignedDistance(plane, sphereX, sphereY, sphereZ);
+            sphereOutside = _mm256_or_ps(sphereOutside, _mm256_cmp_ps(distance, negativeRadius, _CMP_LT_OQ));
+            sphereInside = _mm256_and_ps(sphereInside, _mm256_cmp_ps(distance, radius, _CMP_GT_OQ));
+        }
+        int outsideMask = _mm256_movemask_ps(sphereOutside);
+        int insideMask = _mm256_movemask_ps(sphereInside);
+        if ((outsideMask | insideMask) == 0xFF) {
+            return static_cast<uint8_t>(insideMask);
+        }
+
+        __m256 maxDistances[Frustum::numPlanes];
+        for (auto &maxDistance: maxDistances) {
+            maxDistance = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+        }
+
+        for (int point = 0; point < TileBounds::numPoints; point++) {
+            __m256 x = load(bounds.getX(point), batch);
+            __m256 y = load(bounds.getY(point), batch);
+            __m256 z = load(bounds.getZ(point), batch);
+            for (int i = 0; i < Frustum::numPlanes; i++) {
+                maxDistances[i] = _mm256_max_ps(maxDistances[i], computeSignedDistance(planes[i], x, y, z));
+            }
+        }
+
+        __m256 negativeSlack = _mm256_sub_ps(_mm256_setzero_ps(), load(bounds.getSlack(), batch));
+        __m256 culled = _mm256_setzero_ps();
+        for (auto maxDistance: maxDistances) {
+            culled = _mm256_or_ps(culled, _mm256_cmp_ps(maxDistance, negativeSlack, _CMP_LT_OQ));
+        }
+        int culledMask = _mm256_movemask_ps(culled);
+        return static_cast<uint8_t>(insideMask | ~(outsideMask | culledMask));
+    }
+
+#elif defined(FRUSTUM_CULLER_SSE)
+
+    inline __m128 load(const float *values, const RangeBatch &batch) {
+        return _mm_loadu_ps(values + batch.firstTile);
+    }
+
+    inline __m128 load(const float *values, const IndexedBatch &batch) {
+        const unsigned int *i = batch.tileIndices;
+        return _mm_setr_ps(values[i[0]], values[i[1]], values[i[2]], values[i[3]]);
+    }
+
+    inline __m128 computeSignedDistance(const float plane[4], __m128 x, __m128 y, __m128 z) {
+        __m128 xy = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane[0])),
+                               _mm_mul_ps(y, _mm_set1_ps(plane[1])));
+        __m128 zw = _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane[2])),
+                               _mm_set1_ps(plane[3]));
+        return _mm_add_ps(xy, zw);
+    }
+
+    /**
+     * Classifies the first 4 tiles of the batch.
+     */
+    template<typename Batch>
+    uint8_t classifyHalfBatch(const Planes &planes, const TileBounds &bounds, const Batch &batch) {
+        // Bounding-sphere pre-test. The sample points are tested only if some
+        // of the spheres intersect the frustum.
+        __m128 sphereX = load(bounds.getSphereX(), batch);
+        __m128 sphereY = load(bounds.getSphereY(), batch);
+        __m128 sphereZ = load(bounds.getSphereZ(), batch);
+        __m128 radius = load(bounds.getSphereRadius(), batch);
+        __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), radius);
+        __m128 sphereOutside = _mm_setzero_ps();
+        __m128 sphereInside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (const auto &plane: planes) {
+            __m128 distance = computeSignedDistance(plane, sphereX, sphereY, sphereZ);
+            sphereOutside = _mm_or_ps(sphereOutside, _mm_cmplt_ps(distance, negativeRadius));
+            sphereInside = _mm_and_ps(sphereInside, _mm_cmpgt_ps(distance, radius));
+        }
+        int outsideMask = _mm_movemask_ps(sphereOutside);
+        int insideMask = _mm_movemask_ps(sphereInside);
+        if ((outsideMask | insideMask) == 0xF) {
+            return static_cast<uint8_t>(insideMask);
+        }
+
+        __m128 maxDistances[Frustum::numPlanes];
+        for (auto &maxDistance: maxDistances) {
+            maxDistance = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+        }
+
+        for (int point = 0; point < TileBounds::numPoints; point++) {
+            __m128 x = load(bounds.getX(point), batch);
+            __m128 y = load(bounds.getY(point), batch);
+            __m128 z = load(bounds.getZ(point), batch);
+            for (int i = 0; i < Frustum::numPlanes; i++) {
+                maxDistances[i] = _mm_max_ps(maxDistances[i], computeSignedDistance(planes[i], x, y, z));
+            }
+        }
+
+        __m128 negativeSlack = _mm_sub_ps(_mm_setzero_ps(), load(bounds.getSlack(), batch));
+        __m128 culled = _mm_setzero_ps();
+        for (auto maxDistance: maxDistances) {
+            culled = _mm_or_ps(culled, _mm_cmplt_ps(maxDistance, negativeSlack));
+        }
+        int culledMask = _mm_movemask_ps(culled);
+        return static_cast<uint8_t>((insideMask | ~(outsideMask | culledMask)) & 0xF);
+    }
+
+    template<typename Batch>
+    uint8_t classifyBatch(const Planes &planes, const TileBounds &bounds, const Batch &batch) {
+        return classifyHalfBatch(planes, bounds, batch) |
+               (classifyHalfBatch(planes, bounds, batch.offset(4)) << 4);
+    }
+
+#else
+
+    template<typename Batch>
+    uint8_t classifyBatch(const Planes &planes, const TileBounds &bounds, const Batch &batch) {
+        uint8_t mask = 0;
+        for (int lane = 0; lane < TileBounds::batchSize; lane++) {
+            if (isTileVisibleScalar(planes, bounds, batch.getTileIndex(lane))) {
+                mask |= 1 << lane;
+            }
+        }
+        return mask;
+    }
+
+#endif
+
+    /**
+     * Classifies the last incomplete batch. The missing lanes repeat the last tile
+     * so that the kernel does not read outside the bounds.
+     */
+    template<typename Batch>
+    uint8_t classifyIncompleteBatch(const Planes &planes, const TileBounds &bounds,
+                                    const Batch &batch, size_t count) {
+        unsigned int tileIndices[TileBounds::batchSize];
+        int numLanes = static_cast<int>(count);
+        for (int lane = 0; lane < TileBounds::batchSize; lane++) {
+            tileIndices[lane] = batch.getTileIndex(lane < numLanes ? lane : numLanes - 1);
+        }
+        uint8_t mask = classifyBatch(planes, bounds, IndexedBatch{tileIndices});
+        return mask & ((1 << count) - 1);
+    }
+}
+
+FrustumCuller::FrustumCuller(const Frustum &frustum) {
+    for (int i = 0; i < Frustum::numPlanes; i++) {
+        const glm::vec4 &plane = frustum.getPlane(i);
+        for (int j = 0; j < 4; j++) {
+            planes[i][j] = plane[j];
+        }
+    }
+}
+
+void FrustumCuller::cullTiles(const TileBounds &bounds, const unsigned int *tileIndices, size_t count,
+                              std::vector<uint8_t> &visibilityMask) const {
+    size_t numBatches = (count + TileBounds::batchSize - 1) / TileBounds::batchSize;
+    size_t numFullBatches = count / TileBounds::batchSize;
+    visibilityMask.resize(numBatches);
+
+    for (size_t batch = 0; batch < numFullBatches; batch++) {
+        IndexedBatch indexedBatch{tileIndices + batch * TileBounds::batchSize};
+        visibilityMask[batch] = classifyBatch(planes, bounds, indexedBatch);
+    }
+    if (numFullBatches < numBatches) {
+        IndexedBatch indexedBatch{tileIndices + numFullBatches * TileBounds::batchSize};
+        size_t remainingTiles = count - numFullBatches * TileBounds::batchSize;
+        visibilityMask[numFullBatches] = classifyIncompleteBatch(planes, bounds, indexedBatch, remainingTiles);
+    }
+}
+
+void FrustumCuller::cullTileRange(const TileBounds &bounds, unsigned int firstTile, size_t count,
+                                  std::vector<uint8_t> &visibilityMask) const {
+    size_t numBatches = (count + TileBounds::batchSize - 1) / TileBounds::batchSize;
+    size_t numFullBatches = count / TileBounds::batchSize;
+    visibilityMask.resize(numBatches);
+
+    for (size_t batch = 0; batch < numFullBatches; batch++) {
+        RangeBatch rangeBatch{firstTile + static_cast<unsigned int>(batch * TileBounds::batchSize)};
+        visibilityMask[batch] = classifyBatch(planes, bounds, rangeBatch);
+    }
+    if (numFullBatches < numBatches) {
+        RangeBatch rangeBatch{firstTile + static_cast<unsigned int>(numFullBatches * TileBounds::batchSize)};
+        size_t remainingTiles = count - numFullBatches * TileBounds::batchSize;
+        visibilityMask[numFullBatches] = classifyIncompleteBatch(planes, bounds, rangeBatch, remainingTiles);
+    }
+}
+
+bool FrustumCuller::isTileVisible(const TileBounds &bounds, unsigned int tileIndex) const {
+    return isTileVisibleScalar(planes, bounds, tileIndex);
+}
+
+const char *FrustumCuller::getInstructionSet() {
+#if defined(FRUSTUM_CULLER_AVX) && defined(__AVX2__)
+    return "AVX2";
+#elif defined(FRUSTUM_CULLER_AVX)
+    return "AVX";
+#elif defined(FRUSTUM_CULLER_SSE)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,56 @@
+#ifndef EARTH_VISUALIZATION_FRUSTUMCULLER_H
+#define EARTH_VISUALIZATION_FRUSTUMCULLER_H
+
+#include <cstdint>
+#include <vector>
+#include "TileBounds.h"
+#include "../Frustum.h"
+
+/**
+ * Classifies batches of tiles against the view frustum using the structure-of-arrays
+ * tile bounds. A tile is culled if its bounding sphere is outside the frustum, or if all
+ * its sample points (extended by the slack of the tile) are outside the same plane.
+ * Tiles with the bounding sphere completely inside the frustum are visible.
+ *
+ * The kernels process 8 tiles per iteration with AVX or SSE, depending on the instruction
+ * set the application is compiled for, and fall back to scalar code otherwise.
+ * The result is a bitmask, in which bit (i % 8) of byte (i / 8) is set if the i-th
+ * classified tile is potentially visible.
+ */
+class FrustumCuller {
+private:
+    float planes[Frustum::numPlanes][4];
+
+public:
+    explicit FrustumCuller(const Frustum &frustum);
+
+    /**
+     * Classifies the tiles with the given indices, e.g., the children of all tiles refined
+     * at a certain depth of the quadtree.
+     */
+    void cullTiles(const TileBounds &bounds, const unsigned int *tileIndices, size_t count,
+                   std::vector<uint8_t> &visibilityMask) const;
+
+    /**
+     * Classifies a contiguous range of tiles.
+     */
+    void cullTileRange(const TileBounds &bounds, unsigned int firstTile, size_t count,
+                       std::vector<uint8_t> &visibilityMask) const;
+
+    /**
+     * Scalar classification of a single tile. Gives the same results as the batched kernels.
+     */
+    [[nodiscard]] bool isTileVisible(const TileBounds &bounds, unsigned int tileIndex) const;
+
+    [[nodiscard]] static bool isVisible(const std::vector<uint8_t> &visibilityMask, size_t index) {
+        return (visibilityMask[index / 8] >> (index % 8)) & 1;
+    }
+
+    /**
+     * Name of the instruction set used by the batched kernels.
+     */
+    [[nodiscard]] static const char *getInstructionSet();
+};
+
+
+#endif //EARTH_VISUALIZATION_FRUSTUMCULLER_H
@@ -0,0 +1,34 @@
+#include "TileBounds.h"
+
+void TileBounds::build(const std::vector<Tile> &tiles) {
+    numTiles = tiles.size();
+    size_t paddedSize = (numTiles + batchSize - 1) / batchSize * batchSize;
+
+    for (int point = 0; point < numPoints; point++) {
+        x[point].assign(paddedSize, 0.0f);
+        y[point].assign(paddedSize, 0.0f);
+        z[point].assign(paddedSize, 0.0f);
+    }
+    slack.assign(paddedSize, 0.0f);
+    sphereX.assign(paddedSize, 0.0f);
+    sphereY.assign(paddedSize, 0.0f);
+    sphereZ.assign(paddedSize, 0.0f);
+    sphereRadius.assign(paddedSize, 0.0f);
+
+    for (size_t i = 0; i < numTiles; i++) {
+        const Tile &tile = tiles[i];
+        const auto &samplePoints = tile.getSamplePoints();
+        for (int point = 0; point < numPoints; point++) {
+            x[point][i] = samplePoints[point].x;
+            y[point][i] = samplePoints[point].y;
+            z[point][i] = samplePoints[point].z;
+        }
+        slack[i] = static_cast<float>(tile.getSurfaceDeviation());
+
+        glm::vec3 sphereCentre = tile.getBoundingSphereCentre();
+        sphereX[i] = sphereCentre.x;
+        sphereY[i] = sphereCentre.y;
+        sphereZ[i] = sphereCentre.z;
+        sphereRadius[i] = static_cast<float>(tile.getTileRadius());
+    }
+}
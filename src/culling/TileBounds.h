@@ -0,0 +1,80 @@
+#ifndef EARTH_VISUALIZATION_TILEBOUNDS_H
+#define EARTH_VISUALIZATION_TILEBOUNDS_H
+
+#include <array>
+#include <vector>
+#include <cstddef>
+#include "../tiling/Tile.h"
+
+/**
+ * Geocentric bounds of all tiles in a structure-of-arrays layout, which allows
+ * the culling kernels to process several tiles at once.
+ *
+ * Each tile is described by its bounding sphere, its 9 sample points (4 corners, 4 edge centres,
+ * and the centre), and a slack, which is the maximum distance of the curved surface of the tile
+ * from the polyhedron spanned by the sample points. The i-th element of each array belongs
+ * to the i-th tile of the tile container.
+ */
+class TileBounds {
+public:
+    static const int numPoints = 9;
+    // The arrays are padded so that the kernels can always load a whole batch.
+    static const int batchSize = 8;
+
+private:
+    size_t numTiles = 0;
+    std::array<std::vector<float>, numPoints> x;
+    std::array<std::vector<float>, numPoints> y;
+    std::array<std::vector<float>, numPoints> z;
+    std::vector<float> slack;
+    std::vector<float> sphereX;
+    std::vector<float> sphereY;
+    std::vector<float> sphereZ;
+    std::vector<float> sphereRadius;
+
+public:
+    /**
+     * Copies the sample points of the tiles. The geocentric positions
+     * of the tiles have to be up to date.
+     */
+    void build(const std::vector<Tile> &tiles);
+
+    [[nodiscard]] size_t size() const {
+        return numTiles;
+    }
+
+    [[nodiscard]] const float *getX(int point) const {
+        return x[point].data();
+    }
+
+    [[nodiscard]] const float *getY(int point) const {
+        return y[point].data();
+    }
+
+    [[nodiscard]] const float *getZ(int point) const {
+        return z[point].data();
+    }
+
+    [[nodiscard]] const float *getSlack() const {
+        return slack.data();
+    }
+
+    [[nodiscard]] const float *getSphereX() const {
+        return sphereX.data();
+    }
+
+    [[nodiscard]] const float *getSphereY() const {
+        return sphereY.data();
+    }
+
+    [[nodiscard]] const float *getSphereZ() const {
+        return sphereZ.data();
+    }
+
+    [[nodiscard]] const float *getSphereRadius() const {
+        return sphereRadius.data();
+    }
+};
+
+
+#endif //EARTH_VISUALIZATION_TILEBOUNDS_H
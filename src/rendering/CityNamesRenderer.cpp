@@ -129,7 +129,11 @@ bool CityNamesRenderer::initialize() {
         city.latitude *= -1;
     }
 
-    return program.build() && prepareBuffers() && prepareTextureAtlas();
+    if (!program.build()) {
+        return false;
+    }
+    FrameUniformBuffer::bindToProgram(program);
+    return prepareBuffers() && prepareTextureAtlas();
 }
 
 void CityNamesRenderer::destroy() {
@@ -140,24 +144,6 @@ void CityNamesRenderer::destroy() {
 }
 
 
-glm::mat4 CityNamesRenderer::constructPerspectiveProjectionMatrix(
-        const Camera &camera, const Ellipsoid &ellipsoid, const t_window_definition &window) {
-    // Near and far plane has to be determined from the distance to Earth
-    auto closestPointOnSurface = ellipsoid.projectGeocentricPointOntoSurface(camera.getPosition());
-    auto distanceToSurface = glm::length(camera.getPosition() - closestPointOnSurface);
-    auto distanceToEllipsoidsCenter = glm::length(camera.getPosition() - ellipsoid.getGeocentricPosition());
-
-    // The near plane is set in the middle of the camera position and the surface
-    auto nearPlane = static_cast<float>(distanceToSurface * 0.5);
-    auto farPlane = distanceToEllipsoidsCenter;
-
-    glm::mat4 projectionMatrix;
-    projectionMatrix = glm::perspective(glm::radians(camera.getFov()),
-                                        (float) window.width / (float) window.height,
-                                        nearPlane, farPlane);
-    return projectionMatrix;
-}
-
 void CityNamesRenderer::render(float currentTime, t_window_definition window,
                                RenderingOptions options) {
     if (!options.isRenderingCitiesEnabled) {
@@ -170,12 +156,8 @@ void CityNamesRenderer::render(float currentTime, t_window_definition window,
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    glm::mat4 projectionMatrix = constructPerspectiveProjectionMatrix(camera, ellipsoid, window);
-    program.setMat4("projection", projectionMatrix);
-    glm::mat4 viewMatrix = camera.getViewMatrix();
-    program.setMat4("view", viewMatrix);
-    program.setVec3("ellipsoidRadiiSquared", ellipsoid.getRadiiSquared());
-    Frustum frustum(viewMatrix, projectionMatrix);
+    // The camera and ellipsoid state comes from the frame uniform buffer
+    Frustum frustum(frameUniformBuffer.getViewMatrix(), frameUniformBuffer.getProjectionMatrix());
 
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, textureId);
@@ -328,11 +310,13 @@ void CityNamesRenderer::renderText(const City &text, float sx, float sy, glm::ve
 }
 
 
-CityNamesRenderer::CityNamesRenderer(Program &program, Camera &camera, Ellipsoid &ellipsoid)
-        : program(program), camera(camera), ellipsoid(ellipsoid) {
+CityNamesRenderer::CityNamesRenderer(Program &program, Camera &camera, Ellipsoid &ellipsoid,
+                                     const FrameUniformBuffer &frameUniformBuffer)
+        : program(program), camera(camera), ellipsoid(ellipsoid), frameUniformBuffer(frameUniformBuffer) {
 
 }
 
-void CityNamesRenderer::notify(RenderingStatistics renderingStatistics) {
+void CityNamesRenderer::notify(const RenderingStatistics &renderingStatistics,
+                               const VisibleTiles &visibleTiles) {
     rendereringStats = renderingStatistics;
 }
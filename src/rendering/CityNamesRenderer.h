@@ -15,6 +15,7 @@
 #include "../WorldCitiesReader.h"
 #include "RendererSubscriber.h"
 #include "../Frustum.h"
+#include "FrameUniformBuffer.h"
 #include <glm/vec3.hpp>
 #include <glm/detail/type_vec2.hpp>
 
@@ -48,6 +49,7 @@ private:
     unsigned int VAO, VBO, instanceVBO;
     Camera &camera;
     Ellipsoid &ellipsoid;
+    const FrameUniformBuffer &frameUniformBuffer;
     std::vector<City> worldCities;
     RenderingStatistics rendereringStats;
 
@@ -63,15 +65,13 @@ private:
 
     int setVertexDataForText(const City &text, float sx, float sy, VertexData *vertexData);
 
-    glm::mat4 constructPerspectiveProjectionMatrix(
-            const Camera &camera, const Ellipsoid &ellipsoid, const t_window_definition &window);
-
     bool isRenderedAreaTooBig() const;
 
     void retrieveDataToBeRendered(const Frustum &frustum, std::vector<City> &out) const;
 
 public:
-    explicit CityNamesRenderer(Program &program, Camera &camera, Ellipsoid &ellipsoid);
+    explicit CityNamesRenderer(Program &program, Camera &camera, Ellipsoid &ellipsoid,
+                               const FrameUniformBuffer &frameUniformBuffer);
 
     bool initialize() override;
 
@@ -79,7 +79,7 @@ public:
 
     void render(float currentTime, t_window_definition window, RenderingOptions options) override;
 
-    void notify(RenderingStatistics renderingStatistics) override;
+    void notify(const RenderingStatistics &renderingStatistics, const VisibleTiles &visibleTiles) override;
 };
 
 
@@ -0,0 +1,63 @@
+#ifndef EARTH_VISUALIZATION_DRAWLIST_H
+#define EARTH_VISUALIZATION_DRAWLIST_H
+
+#include <vector>
+#include <memory>
+#include "../textures/Texture.h"
+
+/**
+ * Everything needed to draw a single tile. The textures are either the tile's own
+ * or the closest coarser ones that are ready in OpenGL context.
+ */
+struct TileDrawCommand {
+    unsigned int tileIndex;
+    Texture *dayTexture;
+    Texture *nightTexture;
+    Texture *heightMap;
+};
+
+/**
+ * The result of the CPU part of a frame, which the GL thread only submits.
+ *
+ * Besides the draw commands, it lists the textures the frame wants to use, so that
+ * the GL thread can note their usage or request them from disk, in a deterministic order.
+ * The storage is reused between frames.
+ */
+class DrawList {
+private:
+    std::vector<TileDrawCommand> commands;
+    // Points to the textures owned by the tile resources
+    std::vector<const std::shared_ptr<Texture> *> usedTextures;
+
+public:
+    void clear() {
+        commands.clear();
+        usedTextures.clear();
+    }
+
+    void addCommand(const TileDrawCommand &command) {
+        commands.push_back(command);
+    }
+
+    void addUsedTexture(const std::shared_ptr<Texture> &texture) {
+        usedTextures.push_back(&texture);
+    }
+
+    /**
+     * Appends the commands and textures of another draw list.
+     */
+    void append(const DrawList &other) {
+        commands.insert(commands.end(), other.commands.begin(), other.commands.end());
+        usedTextures.insert(usedTextures.end(), other.usedTextures.begin(), other.usedTextures.end());
+    }
+
+    [[nodiscard]] const std::vector<TileDrawCommand> &getCommands() const {
+        return commands;
+    }
+
+    [[nodiscard]] const std::vector<const std::shared_ptr<Texture> *> &getUsedTextures() const {
+        return usedTextures;
+    }
+};
+
+#endif //EARTH_VISUALIZATION_DRAWLIST_H
@@ -0,0 +1,46 @@
+#include "FrameUniformBuffer.h"
+#include <glm/gtc/matrix_transform.hpp>
+
+bool FrameUniformBuffer::initialize() {
+    glCreateBuffers(1, &UBO);
+    glNamedBufferData(UBO, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, UBO);
+    return true;
+}
+
+void FrameUniformBuffer::render(float currentTime, t_window_definition window, RenderingOptions options) {
+    frameUniforms.view = camera.getViewMatrix();
+    frameUniforms.projection = constructPerspectiveProjectionMatrix(camera, ellipsoid, window);
+    frameUniforms.ellipsoidRadiiSquared = glm::vec4(ellipsoid.getRadiiSquared(), 0.f);
+    frameUniforms.ellipsoidOneOverRadiiSquared = glm::vec4(ellipsoid.getOneOverRadiiSquared(), 0.f);
+    frameUniforms.lightPos = glm::vec4(lightSource.getLightPosition(), 1.f);
+
+    glNamedBufferSubData(UBO, 0, sizeof(FrameUniforms), &frameUniforms);
+}
+
+void FrameUniformBuffer::destroy() {
+    glDeleteBuffers(1, &UBO);
+    UBO = 0;
+}
+
+bool FrameUniformBuffer::bindToProgram(Program &program) {
+    return program.bindUniformBlock(blockName, bindingPoint);
+}
+
+glm::mat4 FrameUniformBuffer::constructPerspectiveProjectionMatrix(
+        const Camera &camera, const Ellipsoid &ellipsoid, const t_window_definition &window) {
+    // Near and far plane has to be determined from the distance to Earth
+    auto closestPointOnSurface = ellipsoid.projectGeocentricPointOntoSurface(camera.getPosition());
+    auto distanceToSurface = glm::length(camera.getPosition() - closestPointOnSurface);
+    auto distanceToEllipsoidsCenter = glm::length(camera.getPosition() - ellipsoid.getGeocentricPosition());
+
+    // The near plane is set in the middle of the camera position and the surface
+    auto nearPlane = static_cast<float>(distanceToSurface * 0.5);
+    auto farPlane = distanceToEllipsoidsCenter;
+
+    glm::mat4 projectionMatrix;
+    projectionMatrix = glm::perspective(glm::radians(camera.getFov()),
+                                        (float) window.width / (float) window.height,
+                                        nearPlane, farPlane);
+    return projectionMatrix;
+}
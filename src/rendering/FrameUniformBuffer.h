@@ -0,0 +1,78 @@
+#ifndef EARTH_VISUALIZATION_FRAMEUNIFORMBUFFER_H
+#define EARTH_VISUALIZATION_FRAMEUNIFORMBUFFER_H
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+#include "Renderer.h"
+#include "program.h"
+#include "../cameras/Camera.h"
+#include "../ellipsoid.h"
+#include "../simulation/LightSource.h"
+
+/**
+ * Per-frame state shared by all shaders, laid out according to std140.
+ * It mirrors the FrameUniforms block declared in the shaders.
+ * The vec3 values occupy a whole vec4 slot in std140.
+ */
+struct FrameUniforms {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec4 ellipsoidRadiiSquared;
+    glm::vec4 ellipsoidOneOverRadiiSquared;
+    glm::vec4 lightPos;
+};
+
+/**
+ * Owns the uniform buffer with the camera, ellipsoid, and light state of the current frame.
+ *
+ * The buffer is written once per frame before any other renderer runs,
+ * so that all passes use the same camera state.
+ */
+class FrameUniformBuffer : public Renderer {
+private:
+    Camera &camera;
+    const Ellipsoid &ellipsoid;
+    const LightSource &lightSource;
+    unsigned int UBO = 0;
+    FrameUniforms frameUniforms{};
+
+public:
+    // The block is bound to this binding point in all programs
+    static const unsigned int bindingPoint = 0;
+    static constexpr const char *blockName = "FrameUniforms";
+
+    explicit FrameUniformBuffer(Camera &camera, const Ellipsoid &ellipsoid, const LightSource &lightSource)
+            : camera(camera), ellipsoid(ellipsoid), lightSource(lightSource) {
+    }
+
+    bool initialize() override;
+
+    /**
+     * Computes the frame uniforms and uploads them to the uniform buffer.
+     */
+    void render(float currentTime, t_window_definition window, RenderingOptions options) override;
+
+    void destroy() override;
+
+    /**
+     * Connects the FrameUniforms block of the program to the shared binding point.
+     * GLSL 4.00 has no binding layout qualifier, so it has to be done after linking.
+     */
+    static bool bindToProgram(Program &program);
+
+    /**
+     * Constructs the projection whose near and far planes are fitted to the distance from the ellipsoid.
+     */
+    static glm::mat4 constructPerspectiveProjectionMatrix(
+            const Camera &camera, const Ellipsoid &ellipsoid, const t_window_definition &window);
+
+    [[nodiscard]] const glm::mat4 &getViewMatrix() const {
+        return frameUniforms.view;
+    }
+
+    [[nodiscard]] const glm::mat4 &getProjectionMatrix() const {
+        return frameUniforms.projection;
+    }
+};
+
+#endif //EARTH_VISUALIZATION_FRAMEUNIFORMBUFFER_H
@@ -73,12 +73,19 @@ void GuiFrameRenderer::createFeaturesWindow(t_window_definition window) {
     ImGui::Spacing();
     ImGui::Checkbox("Culling", &renderingOptions.isCullingEnabled);
     ImGui::Spacing();
+    ImGui::Checkbox("Procedural grid", &renderingOptions.isProceduralGridEnabled);
+    ImGui::Spacing();
     auto sliderFlags = ImGuiSliderFlags_None;
     ImGui::SliderInt("Height factor", &renderingOptions.heightFactor, 1, 10000, "%d", sliderFlags);
     ImGui::Spacing();
+    ImGui::SliderInt("Upload KiB/frame", &renderingOptions.uploadBudgetKiB, 256, 65536, "%d", sliderFlags);
+    ImGui::Spacing();
+    ImGui::SliderFloat("Upload ms/frame", &renderingOptions.uploadBudgetMilliseconds, 0.1f, 16.0f, "%.1f",
+                       sliderFlags);
+    ImGui::Spacing();
 
     ImGui::End();
-    float windowHeight = 280;
+    float windowHeight = 340;
     updateTopPadding(windowHeight);
 }
 
@@ -153,9 +160,19 @@ void GuiFrameRenderer::createStatisticsWindow(t_window_definition window) {
     ImGui::Spacing();
     ImGui::Text("Tiles: %d", renderingStatistics.numTiles);
     ImGui::Spacing();
+    ImGui::Text("Visited tiles: %d", renderingStatistics.visitedTiles);
+    ImGui::Spacing();
+    ImGui::Text("Rendered tiles: %d", renderingStatistics.renderedTiles);
+    ImGui::Spacing();
+    ImGui::Text("Draw calls: %d", renderingStatistics.drawCalls);
+    ImGui::Spacing();
     ImGui::Text("Frustum-culled tiles: %d", renderingStatistics.frustumCulledTiles);
     ImGui::Spacing();
-    ImGui::Text("Back-faced-culled tiles: %d", renderingStatistics.backfacedCulledTiles);
+    ImGui::Text("Horizon-culled tiles: %d", renderingStatistics.horizonCulledTiles);
+    ImGui::Spacing();
+    ImGui::Text("Re-evaluated tiles: %d", renderingStatistics.reevaluatedTiles);
+    ImGui::Spacing();
+    ImGui::Text("Reused tiles: %d", renderingStatistics.reusedTiles);
     ImGui::Spacing();
     ImGui::Separator();
     ImGui::Spacing();
@@ -163,6 +180,16 @@ void GuiFrameRenderer::createStatisticsWindow(t_window_definition window) {
     ImGui::Spacing();
     ImGui::Text("Loaded textures: %d", renderingStatistics.loadedTextures);
     ImGui::Spacing();
+    ImGui::Text("Texture memory: %.1f MiB",
+                static_cast<double>(renderingStatistics.residentTextureBytes) / (1024 * 1024));
+    ImGui::Spacing();
+    ImGui::Text("Waiting for upload: %d", renderingStatistics.waitingTextures);
+    ImGui::Spacing();
+    ImGui::Text("Pending requests: %d", renderingStatistics.pendingRequests);
+    ImGui::Spacing();
+    ImGui::Text("Pixel buffer hits/misses: %lu/%lu", renderingStatistics.pixelBufferHits,
+                renderingStatistics.pixelBufferMisses);
+    ImGui::Spacing();
     ImGui::Separator();
     ImGui::Spacing();
     ImGui::Text("\tCamera");
@@ -216,6 +243,6 @@ void GuiFrameRenderer::destroy() {
 
 }
 
-void GuiFrameRenderer::notify(RenderingStatistics statistics) {
+void GuiFrameRenderer::notify(const RenderingStatistics &statistics, const VisibleTiles &visibleTiles) {
     renderingStatistics = statistics;
 }
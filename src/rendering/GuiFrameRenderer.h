@@ -47,7 +47,7 @@ public:
 
     RenderingOptions getRenderingOptions() const;
 
-    void notify(RenderingStatistics renderingStatistics) override;
+    void notify(const RenderingStatistics &renderingStatistics, const VisibleTiles &visibleTiles) override;
 };
 
 
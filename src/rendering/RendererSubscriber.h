@@ -7,12 +7,28 @@
 
 #include <glm/vec3.hpp>
 #include <glm/vec2.hpp>
+#include "VisibleTiles.h"
 
 struct RenderingStatistics {
     unsigned int frustumCulledTiles = 0;
-    unsigned int backfacedCulledTiles = 0;
+    unsigned int horizonCulledTiles = 0;
     unsigned int numTiles = 0;
+    unsigned int visitedTiles = 0;
+    unsigned int renderedTiles = 0;
+    unsigned int drawCalls = 0;
+    // Visited tiles whose culling and LOD decisions were computed in this frame or taken over from the cache
+    unsigned int reevaluatedTiles = 0;
+    unsigned int reusedTiles = 0;
     unsigned int loadedTextures = 0;
+    // Video memory taken up by the loaded textures
+    size_t residentTextureBytes = 0;
+    // Loaded textures carried over to the next frame because of the upload budget
+    unsigned int waitingTextures = 0;
+    // Requests the loader has not started decoding
+    unsigned int pendingRequests = 0;
+    // Decoded tiles that reused a pooled buffer, or had to allocate a new one
+    unsigned long pixelBufferHits = 0;
+    unsigned long pixelBufferMisses = 0;
     glm::vec3 cameraPosition = glm::vec3(0, 0, 0);
     glm::vec2 renderedLatitudeRange = glm::vec2(0, 0);
     glm::vec2 renderedLongitudeRange = glm::vec2(0, 0);
@@ -20,7 +36,11 @@ struct RenderingStatistics {
 
 class RendererSubscriber {
 public:
-    virtual void notify(RenderingStatistics renderingStatistics) = 0;
+    /**
+     * Called once per frame. The visible tiles are valid only during the call.
+     */
+    virtual void notify(const RenderingStatistics &renderingStatistics,
+                        const VisibleTiles &visibleTiles) = 0;
 };
 
 
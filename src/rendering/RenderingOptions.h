@@ -16,8 +16,14 @@ struct RenderingOptions {
     bool isGridEnabled = false;
     bool isCullingEnabled = true;
     bool isRenderingCitiesEnabled = true;
+    // Generate the tile grid in the vertex shader instead of reading it from vertex buffers
+    bool isProceduralGridEnabled = false;
     int simulationSpeed = 1;
     int heightFactor = 1000;
+    // Limits on moving loaded textures into the OpenGL context in a single frame.
+    // The rest waits for the following frames.
+    int uploadBudgetKiB = 8192;
+    float uploadBudgetMilliseconds = 2.0f;
 };
 
 
@@ -12,6 +12,7 @@ bool SunRenderer::initialize() {
     if (!isShaderProgramBuilt) {
         return false;
     }
+    FrameUniformBuffer::bindToProgram(program);
 
     constructVertices();
     setupVertexArrays();
@@ -71,9 +72,10 @@ void SunRenderer::render(float currentTime, t_window_definition window, Renderin
     }
 
     // program.setVec3("sunLocation", sunLocation);
+    // The view matrix comes from the frame uniform buffer. The Sun is far behind
+    // the far plane of the shared projection, so it uses its own projection.
     program.setMat4("model", getModelMatrix());
-    program.setMat4("projection", getProjectionMatrix(window));
-    program.setMat4("view", camera.getViewMatrix());
+    program.setMat4("sunProjection", getProjectionMatrix(window));
 
     if (options.isWireframeEnabled) {
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -12,6 +12,7 @@
 #include "../cameras/FreeCamera.h"
 #include "../vertex.h"
 #include "../simulation/LightSource.h"
+#include "FrameUniformBuffer.h"
 
 class SunRenderer : public Renderer {
 private:
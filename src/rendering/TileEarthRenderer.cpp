@@ -4,68 +4,116 @@
 #include "../utils.h"
 #include <unistd.h>
 #include <algorithm>
+#include <limits>
+#include <tuple>
+#include <chrono>
+#include <iterator>
 
 bool TileEarthRenderer::initialize() {
     // Configure tiles to use the current ellipsoid
-    for (Tile &tile: tileContainer.getTiles()) {
-        tile.updateGeocentricPosition(ellipsoid);
-    }
+    tileContainer.updateGeocentricPositions(ellipsoid);
+    tileSelector.invalidate();
 
     bool isShaderProgramBuilt = program.build();
     if (!isShaderProgramBuilt) {
         return false;
     }
-    int numLevels = tileContainer.getNumLevels();
-    initVertexArraysForAllLevels(numLevels);
+    FrameUniformBuffer::bindToProgram(program);
+    resolveUniformLocations();
+    // Staging memory for asynchronous texture uploads
+    resourceManager.initialize();
+    // The vertex arrays of all levels read the per-instance attributes from this buffer
+    glCreateBuffers(1, &instanceVBO);
+    levelMeshes.resize(tileContainer.getNumLevels());
+
+    glGenVertexArrays(1, &proceduralGridVAO);
+    glBindVertexArray(proceduralGridVAO);
+    setupInstanceAttributes();
 
     return true;
 }
 
+void TileEarthRenderer::resolveUniformLocations() {
+    uniforms.dayTextureSampler = program.getUniformLocation("dayTextureSampler");
+    uniforms.nightTextureSampler = program.getUniformLocation("nightTextureSampler");
+    uniforms.heightMapSampler = program.getUniformLocation("heightMapSampler");
+    uniforms.useDayTexture = program.getUniformLocation("useDayTexture");
+    uniforms.isNightEnabled = program.getUniformLocation("isNightEnabled");
+    uniforms.displayGrid = program.getUniformLocation("displayGrid");
+    uniforms.isTerrainEnabled = program.getUniformLocation("isTerrainEnabled");
+    uniforms.isTerrainShadingEnabled = program.getUniformLocation("isTerrainShadingEnabled");
+    uniforms.gridResolution = program.getUniformLocation("gridResolution");
+    uniforms.gridLineWidth = program.getUniformLocation("gridLineWidth");
+    uniforms.blendDuration = program.getUniformLocation("blendDuration");
+    uniforms.blendDurationScale = program.getUniformLocation("blendDurationScale");
+    uniforms.heightDisplacementFactor = program.getUniformLocation("heightDisplacementFactor");
+    uniforms.heightScale = program.getUniformLocation("heightScale");
+    uniforms.model = program.getUniformLocation("model");
+    uniforms.useProceduralGrid = program.getUniformLocation("useProceduralGrid");
+    uniforms.meshGridResolution = program.getUniformLocation("meshGridResolution");
+}
+
 /**
- * Creates a vertex buffer for each level of detail (LOD).
+ * Returns the vertex and index buffers of a level of detail (LOD).
  *
- * These vertex buffers contain the full geometry of each level.
- *
- * @param numLevels The number of level of details.
+ * These buffers contain the geometry of a single tile of the level.
+ * They are not needed if the grid is generated procedurally.
  */
-void TileEarthRenderer::initVertexArraysForAllLevels(int numLevels) {
-    for (int level = 0; level < numLevels; level++) {
-        Mesh_t fullMeshForThisLevel;
-        // Merge all tile meshes of this level together.
-        for (Tile &tile: tileContainer.getTiles()) {
-            auto resources = tile.getResourcesByLevel(level);
-
-            Mesh_t mesh = resources->getMesh();
-            fullMeshForThisLevel.insert(fullMeshForThisLevel.end(), mesh.begin(), mesh.end());
-            break; // TODO: remove cycle. All tiles share the same mesh.
-        }
-
-        std::vector<t_vertex> verticesForThisLevel = convertToVertices(fullMeshForThisLevel);
-
-        unsigned int VAO, VBO;
-        setupVertexArray(verticesForThisLevel, VAO, VBO);
-
-        for (Tile &tile: tileContainer.getTiles()) {
-            auto resources = tile.getResourcesByLevel(level);
-            resources->meshVAO = VAO;
-            resources->meshVBO = VBO;
-        }
+const LevelMeshBuffers &TileEarthRenderer::getLevelMeshBuffers(int level) {
+    LevelMeshBuffers &meshBuffers = levelMeshes[level];
+    if (meshBuffers.VAO == 0) {
+        // All tiles of this level share the same mesh.
+        meshBuffers = setupVertexArray(tileContainer.getMesh(level));
     }
+    return meshBuffers;
 }
 
-void TileEarthRenderer::setupVertexArray(std::vector<t_vertex> vertices,
-                                         unsigned int &VAO, unsigned int &VBO) {
-    glCreateBuffers(1, &VBO);
+LevelMeshBuffers TileEarthRenderer::setupVertexArray(const TileMesh &tileMesh) {
+    const IndexedMesh &mesh = tileMesh.getIndexedMesh();
+    LevelMeshBuffers meshBuffers;
+    std::vector<t_tile_vertex> vertices = convertToTileVertices(mesh.vertices);
 
-    glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
+    glCreateBuffers(1, &meshBuffers.VBO);
+    glCreateBuffers(1, &meshBuffers.EBO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glNamedBufferData(VBO, vertices.size() * sizeof(t_vertex), &vertices.front(), GL_STATIC_DRAW);
+    glGenVertexArrays(1, &meshBuffers.VAO);
+    glBindVertexArray(meshBuffers.VAO);
 
-    // Position
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *) 0);
+    glBindBuffer(GL_ARRAY_BUFFER, meshBuffers.VBO);
+    glNamedBufferData(meshBuffers.VBO, vertices.size() * sizeof(t_tile_vertex), vertices.data(), GL_STATIC_DRAW);
+
+    // Indices are stored in 16 bits whenever possible to halve the index buffer
+    meshBuffers.numIndices = mesh.indices.size();
+    if (mesh.vertices.size() <= std::numeric_limits<unsigned short>::max() + 1u) {
+        std::vector<unsigned short> shortIndices(mesh.indices.begin(), mesh.indices.end());
+        meshBuffers.indexType = GL_UNSIGNED_SHORT;
+        glNamedBufferData(meshBuffers.EBO, shortIndices.size() * sizeof(unsigned short),
+                          shortIndices.data(), GL_STATIC_DRAW);
+    } else {
+        meshBuffers.indexType = GL_UNSIGNED_INT;
+        glNamedBufferData(meshBuffers.EBO, mesh.indices.size() * sizeof(unsigned int),
+                          mesh.indices.data(), GL_STATIC_DRAW);
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshBuffers.EBO);
+
+    // Position within the tile, normalized from 16-bit integers to [0, 1]
+    glVertexAttribPointer(0, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(t_tile_vertex), (void *) 0);
     glEnableVertexAttribArray(0);
+
+    setupInstanceAttributes();
+    return meshBuffers;
+}
+
+void TileEarthRenderer::setupInstanceAttributes() {
+    // Per-instance attributes: bounds of the tile, the day, night, and height textures, and their layers
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    for (int attribute = 0; attribute < 5; attribute++) {
+        GLuint location = 1 + attribute;
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(TileInstance),
+                              (void *) (attribute * sizeof(glm::vec4)));
+        glVertexAttribDivisor(location, 1); // Data is per instance
+        glEnableVertexAttribArray(location);
+    }
 }
 
 bool TileEarthRenderer::prepareTexture(const std::shared_ptr<Texture> &texture) {
@@ -74,184 +122,332 @@ bool TileEarthRenderer::prepareTexture(const std::shared_ptr<Texture> &texture)
         // Notify the resource manager about the current usage of textures
         resourceManager.noteUsage(texture);
         return true;
+    } else if (texture->isUploadPending()) {
+        // The pixels are on their way to the GPU
+        return false;
     } else {
+        float priority = getTextureRelevance(texture.get());
         // Check if a request has been made for this texture
         auto it = requestMap.find(texture->getPath());
         if (it == requestMap.end()) {
             // The texture hasn't been loaded from disk
             TextureLoadRequest request = {
-                    .path = texture->getPath()
+                    .path = texture->getPath(),
+                    .stagingRing = resourceManager.getStagingRing(),
+                    .priority = priority,
+                    .pack = texture->getPack(),
+                    .packTileIndex = texture->getPackTileIndex()
             };
             resourceFetcher.request(request);
             // Register a request into a data structure
             // so that it can be connected to a TextureLoadResult by the path
             requestMap[texture->getPath()] = texture;
+        } else {
+            // Keep the request alive. Nothing happens if it is already being decoded.
+            resourceFetcher.updatePriority(texture->getPath(), priority);
         }
         return false;
 
     }
 }
 
-void TileEarthRenderer::updateTexturesWithData(const std::vector<TextureLoadResult> &results) {
-    for (const TextureLoadResult &result: results) {
-        // Get the instance of the texture from the HashMap
-        auto it = requestMap.find(result.path);
-        if (it != requestMap.end()) {
-            std::shared_ptr<Texture> texture = it->second;
+size_t TileEarthRenderer::updateTextureWithData(TextureLoadResult &result) {
+    // Get the instance of the texture from the HashMap
+    auto it = requestMap.find(result.path);
+    if (it == requestMap.end()) {
+        if (result.stagedPixels.isValid()) {
+            resourceManager.discardStagedPixels(result.stagedPixels);
+        }
+        return 0;
+    }
+    std::shared_ptr<Texture> texture = it->second;
+    texture->setChannels(result.channels);
+    texture->setNumMipLevels(result.numMipLevels);
 
-            // Copy the data from the TextureLoadResult to the texture instance.
-            texture->setData(result.data);
-            texture->setChannels(result.channels);
+    // Remove the registration from the HashMap
+    requestMap.erase(it);
 
-            // Remove the registration from the HashMap
-            requestMap.erase(it);
+    assert(result.width == texture->getResolution().getWidth());
+    assert(result.height == texture->getResolution().getHeight());
 
-            assert(result.width == texture->getResolution().getWidth());
-            assert(result.height == texture->getResolution().getHeight());
+    if (result.stagedPixels.isValid()) {
+        // The pixels are already in the staging buffer; the upload does not block
+        resourceManager.addTextureIntoContext(texture, result.stagedPixels);
+    } else {
+        // Hand the pixels over from the TextureLoadResult to the texture instance.
+        texture->setData(std::move(result.data), std::move(result.mipLevels));
+        // Now, the texture is loaded and can be prepared for OpenGL
+        resourceManager.addTextureIntoContext(texture);
+    }
+    return texture->getResidentSize();
+}
 
-            // Now, the texture is loaded and can be prepared for OpenGL
-            resourceManager.addTextureIntoContext(texture);
+void TileEarthRenderer::updateTextureRelevance() {
+    textureRelevance.clear();
+    glm::vec3 cameraPosition = camera.getPosition();
+    for (const VisibleTile &visibleTile: tileSelector.getVisibleTiles()) {
+        const Tile &tile = tileContainer.getTile(visibleTile.tileIndex);
+        // Proportional to the error of the tile projected onto the screen
+        float distance = glm::length(tile.getGeocentricPosition() - cameraPosition);
+        auto relevance = static_cast<float>(tile.getGeometricError() / std::max(distance, 1e-6f));
+
+        const TileResources &resources = *tile.getResources();
+        for (TextureType textureType: {TextureType::Day, TextureType::Night, TextureType::HeightMap}) {
+            const Texture *texture = resources.getTexture(textureType).get();
+            float &textureScore = textureRelevance[texture];
+            textureScore = std::max(textureScore, relevance);
         }
     }
 }
 
-bool TileEarthRenderer::getOrPrepareTexture(
-        const std::shared_ptr<TileResources> &resources,
-        const Tile &tile,
-        const TextureType textureType,
-        std::shared_ptr<Texture> &texture) {
+float TileEarthRenderer::getTextureRelevance(const Texture *texture) const {
+    auto relevance = textureRelevance.find(texture);
+    return relevance != textureRelevance.end() ? relevance->second : 0.0f;
+}
 
-    // Set up the neccessary texture
-    texture = resources->getTexture(textureType);
+void TileEarthRenderer::integrateLoadedTextures(const RenderingOptions &options) {
+    if (loadedResults.empty()) {
+        return;
+    }
 
-    // Request and prepare the texture
-    bool textureReady = prepareTexture(texture);
-    if (!textureReady) {
-        // Search for coarser textures
-        textureReady = resources->getCoarserTexture(texture, textureType);
+    // Ranked by the relevance from the previous frame. Textures of tiles that are no longer visible come last.
+    auto getRelevance = [this](const TextureLoadResult &result) {
+        auto request = requestMap.find(result.path);
+        if (request == requestMap.end()) {
+            return std::numeric_limits<float>::infinity(); // Discarded right away at no cost
+        }
+        return getTextureRelevance(request->second.get());
+    };
+    std::vector<std::pair<float, size_t>> order;
+    order.reserve(loadedResults.size());
+    for (size_t i = 0; i < loadedResults.size(); i++) {
+        order.emplace_back(getRelevance(loadedResults[i]), i);
+    }
+    std::stable_sort(order.begin(), order.end(), [](const auto &first, const auto &second) {
+        return first.first > second.first;
+    });
+
+    // At least one texture is integrated each frame so that loading always progresses
+    size_t byteBudget = static_cast<size_t>(std::max(options.uploadBudgetKiB, 0)) * 1024;
+    auto timeBudget = std::chrono::duration<float, std::milli>(options.uploadBudgetMilliseconds);
+    auto startTime = std::chrono::steady_clock::now();
+    size_t uploadedBytes = 0;
+    size_t numIntegrated = 0;
+    for (; numIntegrated < order.size(); numIntegrated++) {
+        bool isOverBudget = uploadedBytes >= byteBudget ||
+                            std::chrono::steady_clock::now() - startTime >= timeBudget;
+        if (numIntegrated > 0 && isOverBudget) {
+            break;
+        }
+        uploadedBytes += updateTextureWithData(loadedResults[order[numIntegrated].second]);
+    }
+
+    // Carry the rest over to the next frame
+    std::vector<TextureLoadResult> remainingResults;
+    remainingResults.reserve(order.size() - numIntegrated);
+    for (size_t i = numIntegrated; i < order.size(); i++) {
+        remainingResults.push_back(std::move(loadedResults[order[i].second]));
+    }
+    loadedResults = std::move(remainingResults);
+}
+
+static glm::vec4 getTextureInstanceAttribute(Texture *texture) {
+    glm::vec2 geodeticOffset = utils::convertToRads(texture->getGeodeticOffset());
+    glm::vec2 gridSize = texture->getTextureGridSize();
+    return {geodeticOffset.x, geodeticOffset.y, gridSize.x, gridSize.y};
+}
 
-        // And, possibly, search for fine-grained textures
-        if (!textureReady) {
-            textureReady = resources->getFinerTexture(tile, texture, textureType);
+void TileEarthRenderer::buildBatches(const DrawList &drawList) {
+    // Tiles of the same level drawn from the same texture arrays are next to each other.
+    // Tiles of the same size and format share texture arrays of many layers, so a level
+    // is usually drawn in a few batches.
+    sortedCommands.assign(drawList.getCommands().begin(), drawList.getCommands().end());
+    auto getBatchKey = [this](const TileDrawCommand &command) {
+        return std::make_tuple(tileContainer.getTile(command.tileIndex).getLevel(),
+                               command.dayTexture->getTextureId(),
+                               command.nightTexture->getTextureId(),
+                               command.heightMap->getTextureId());
+    };
+    std::stable_sort(sortedCommands.begin(), sortedCommands.end(),
+                     [&getBatchKey](const TileDrawCommand &first, const TileDrawCommand &second) {
+                         return getBatchKey(first) < getBatchKey(second);
+                     });
+
+    instances.clear();
+    batches.clear();
+    for (const TileDrawCommand &command: sortedCommands) {
+        const Tile &tile = tileContainer.getTile(command.tileIndex);
+        unsigned int dayTextureArray = command.dayTexture->getTextureId();
+        unsigned int nightTextureArray = command.nightTexture->getTextureId();
+        unsigned int heightMapArray = command.heightMap->getTextureId();
+        bool continuesBatch = !batches.empty() &&
+                              batches.back().level == tile.getLevel() &&
+                              batches.back().dayTextureArray == dayTextureArray &&
+                              batches.back().nightTextureArray == nightTextureArray &&
+                              batches.back().heightMapArray == heightMapArray;
+        if (continuesBatch) {
+            batches.back().numInstances++;
+        } else {
+            batches.push_back({tile.getLevel(), dayTextureArray, nightTextureArray, heightMapArray,
+                               static_cast<unsigned int>(instances.size()), 1});
         }
+
+        TileInstance instance{};
+        instance.tileBounds = glm::vec4(tile.getLongitude(), tile.getLatitude(),
+                                        tile.getLongitudeWidth(), tile.getLatitudeWidth());
+        instance.dayTexture = getTextureInstanceAttribute(command.dayTexture);
+        instance.nightTexture = getTextureInstanceAttribute(command.nightTexture);
+        instance.heightMap = getTextureInstanceAttribute(command.heightMap);
+        instance.textureLayers = glm::vec4(command.dayTexture->getLayer(), command.nightTexture->getLayer(),
+                                           command.heightMap->getLayer(), 0.f);
+        instances.push_back(instance);
+    }
+}
+
+void TileEarthRenderer::uploadInstances() {
+    if (instances.empty()) {
+        return;
+    }
+    size_t size = instances.size() * sizeof(TileInstance);
+    if (size > instanceBufferCapacity) {
+        // Grow the buffer, keeping some space for the following frames
+        instanceBufferCapacity = size * 2;
+        glNamedBufferData(instanceVBO, static_cast<GLsizeiptr>(instanceBufferCapacity), nullptr, GL_DYNAMIC_DRAW);
     }
-    return textureReady;
+    glNamedBufferSubData(instanceVBO, 0, static_cast<GLsizeiptr>(size), instances.data());
+}
+
+unsigned int TileEarthRenderer::submitBatches(bool useProceduralGrid) {
+    unsigned int drawCalls = 0;
+    const TileBatch *previousBatch = nullptr;
+    for (const TileBatch &batch: batches) {
+        // Rebind only what has changed since the previous batch
+        if (previousBatch == nullptr || previousBatch->dayTextureArray != batch.dayTextureArray) {
+            glBindTextureUnit(0, batch.dayTextureArray);
+        }
+        if (previousBatch == nullptr || previousBatch->nightTextureArray != batch.nightTextureArray) {
+            glBindTextureUnit(1, batch.nightTextureArray);
+        }
+        if (previousBatch == nullptr || previousBatch->heightMapArray != batch.heightMapArray) {
+            glBindTextureUnit(2, batch.heightMapArray);
+        }
+        if (useProceduralGrid) {
+            // The vertex shader derives the vertices of the grid from their IDs
+            Resolution resolution = tileContainer.getMesh(batch.level).getResolution();
+            glm::vec2 gridResolution(resolution.getWidth(), resolution.getHeight());
+            program.setVec2(uniforms.meshGridResolution, gridResolution);
+            if (previousBatch == nullptr) {
+                glBindVertexArray(proceduralGridVAO);
+            }
+
+            auto numVertices = static_cast<GLsizei>(resolution.getWidth() * resolution.getHeight() * 6);
+            glDrawArraysInstancedBaseInstance(GL_PATCHES, 0, numVertices,
+                                              static_cast<GLsizei>(batch.numInstances), batch.firstInstance);
+        } else {
+            const LevelMeshBuffers &meshBuffers = getLevelMeshBuffers(batch.level);
+            if (previousBatch == nullptr || previousBatch->level != batch.level) {
+                // All tiles of the same level share the vertex array
+                glBindVertexArray(meshBuffers.VAO);
+            }
+
+            glDrawElementsInstancedBaseInstance(GL_PATCHES, static_cast<GLsizei>(meshBuffers.numIndices),
+                                                meshBuffers.indexType, nullptr,
+                                                static_cast<GLsizei>(batch.numInstances), batch.firstInstance);
+        }
+        drawCalls++;
+        previousBatch = &batch;
+    }
+    return drawCalls;
 }
 
 void TileEarthRenderer::render(float currentTime, t_window_definition window, RenderingOptions options) {
+    // Textures uploaded during previous frames become usable
+    resourceManager.completeUploads();
+    // Forget the requests for textures that have not been wanted for a while,
+    // so that they are requested again if they become visible.
+    for (const std::string &path: resourceFetcher.advanceFrame()) {
+        requestMap.erase(path);
+    }
     auto newlyLoadedTexturesData = resourceFetcher.retrieveLoadedResources();
-    updateTexturesWithData(newlyLoadedTexturesData);
+    std::move(newlyLoadedTexturesData.begin(), newlyLoadedTexturesData.end(), std::back_inserter(loadedResults));
+    integrateLoadedTextures(options);
 
     program.use();
-    program.setInt("dayTextureSampler", 0); // Texture Unit 0
-    program.setInt("nightTextureSampler", 1); // Texture Unit 1
-    program.setInt("heightMapSampler", 2); // Texture Unit 2
-    program.setBool("useDayTexture", options.isTextureEnabled);
-    program.setBool("isNightEnabled", options.isNightEnabled);
-    program.setBool("displayGrid", options.isGridEnabled);
-    program.setBool("isTerrainEnabled", options.isTerrainEnabled);
-    program.setBool("isTerrainShadingEnabled", options.isTerrainShadingEnabled);
-
-    program.setFloat("gridResolution", 0.05);
-    program.setFloat("gridLineWidth", 2);
+    program.setInt(uniforms.dayTextureSampler, 0); // Texture Unit 0
+    program.setInt(uniforms.nightTextureSampler, 1); // Texture Unit 1
+    program.setInt(uniforms.heightMapSampler, 2); // Texture Unit 2
+    program.setBool(uniforms.useDayTexture, options.isTextureEnabled);
+    program.setBool(uniforms.isNightEnabled, options.isNightEnabled);
+    program.setBool(uniforms.displayGrid, options.isGridEnabled);
+    program.setBool(uniforms.isTerrainEnabled, options.isTerrainEnabled);
+    program.setBool(uniforms.isTerrainShadingEnabled, options.isTerrainShadingEnabled);
+
+    program.setFloat(uniforms.gridResolution, 0.05);
+    program.setFloat(uniforms.gridLineWidth, 2);
 
     // Day/night blending
     float blendDuration = 0.3f;
-    program.setFloat("blendDuration", blendDuration);
-    program.setFloat("blendDurationScale", 1 / (2 * blendDuration));
+    program.setFloat(uniforms.blendDuration, blendDuration);
+    program.setFloat(uniforms.blendDurationScale, 1 / (2 * blendDuration));
 
     // Height map settings
     double ellipsoidScaleFactor = ellipsoid.getRealityScaleFactor();
     double displacementFactor = 25. / ellipsoidScaleFactor * options.heightFactor;
-    program.setFloat("heightDisplacementFactor", static_cast<float>(displacementFactor));
-    program.setInt("heightScale", options.heightFactor);
-
-    // Set up model, view, and projection matrix
-    Frustum frustum = setupMatrices(currentTime, window);
-    // Set ellipsoid parameters for the vertex program
-    program.setVec3("ellipsoidRadiiSquared", ellipsoid.getRadiiSquared());
-    program.setVec3("ellipsoidOneOverRadiiSquared", ellipsoid.getOneOverRadiiSquared());
-    program.setVec3("lightPos", lightSource.getLightPosition());
+    program.setFloat(uniforms.heightDisplacementFactor, static_cast<float>(displacementFactor));
+    program.setInt(uniforms.heightScale, options.heightFactor);
+
+    // Raised terrain must not be culled. The bounds are only recomputed when the terrain changes.
+    double heightDisplacement = options.isTerrainEnabled ? displacementFactor : 0;
+    if (heightDisplacement != tileHeightDisplacement) {
+        tileContainer.updateMaxHeightDisplacement(ellipsoid, heightDisplacement);
+        tileSelector.invalidate();
+        tileHeightDisplacement = heightDisplacement;
+    }
 
-    auto tiles = tileContainer.getTiles();
-    auto cameraPosition = camera.getPosition();
+    // Set up the model matrix. The view and projection matrices, ellipsoid parameters,
+    // and light position come from the frame uniform buffer.
+    Frustum frustum = setupMatrices(currentTime);
 
     RenderingStatistics renderingStats;
-    renderingStats.numTiles = tiles.size();
+    renderingStats.numTiles = tileContainer.getTiles().size();
 
-    double screenSpaceWidth = window.width;
     double minLatitude = std::numeric_limits<double>::infinity();
     double minLongitude = std::numeric_limits<double>::infinity();
     double maxLatitude = -std::numeric_limits<double>::infinity();
     double maxLongitude = -std::numeric_limits<double>::infinity();
 
-    std::vector<Tile> renderedTiles;
+    // The CPU part of the frame runs on the thread pool and produces a draw list.
+    tileSelector.select(frustum, camera, ellipsoid, window, resourceManager.getResidencyVersion(),
+                        options, renderingStats);
+    const VisibleTiles &visibleTiles = tileSelector.getVisibleTiles();
+    const DrawList &drawList = tileSelector.getDrawList();
+    renderingStats.renderedTiles = visibleTiles.size();
 
-    for (Tile &tile: tiles) {
-        if (options.isCullingEnabled) {
-            // Frustum culling
-            if (!tile.isInViewFrustum(frustum)) {
-                renderingStats.frustumCulledTiles++;
-                continue;
-            }
-            // Backface culling
-            if (!tile.isFacingCamera(cameraPosition)) {
-                renderingStats.backfacedCulledTiles++;
-                continue;
-            }
-        }
-        renderedTiles.push_back(tile);
+    for (const VisibleTile &visibleTile: visibleTiles) {
+        const Tile &tile = tileContainer.getTile(visibleTile.tileIndex);
         minLongitude = std::min(tile.getLongitude(), minLongitude);
         minLatitude = std::min(tile.getLatitude(), minLatitude);
         maxLongitude = std::max(tile.getLongitude() + tile.getLongitudeWidth(), maxLongitude);
         maxLatitude = std::max(tile.getLatitude() + tile.getLatitudeWidth(), maxLatitude);
+    }
 
-        program.setFloat("uTileLongitudeOffset", tile.getLongitude());
-        program.setFloat("uTileLatitudeOffset", tile.getLatitude());
-        program.setFloat("uTileLongitudeWidth", tile.getLongitudeWidth());
-        program.setFloat("uTileLatitudeWidth", tile.getLatitudeWidth());
-
-        double distanceToCamera = glm::length(camera.getPosition() - tile.getGeocentricPosition());
-        std::shared_ptr<TileResources> resources = tile.getResources(
-                screenSpaceWidth, distanceToCamera, camera);
-        Mesh_t mesh = resources->getMesh();
-
-        std::shared_ptr<Texture> dayTexture;
-        std::shared_ptr<Texture> nightTexture;
-        std::shared_ptr<Texture> heightMap;
-        bool dayTextureReady = getOrPrepareTexture(resources, tile, TextureType::Day, dayTexture);
-        bool nightTextureReady = getOrPrepareTexture(resources, tile, TextureType::Night, nightTexture);
-        bool heightMapReady = getOrPrepareTexture(resources, tile, TextureType::HeightMap, heightMap);
-
-        // Draw only if the necessary resources are ready
-        if (dayTextureReady && nightTextureReady && heightMapReady) {
-            // Set up day texture
-            program.setVec2("dayTextureGeodeticOffset", utils::convertToRads(dayTexture->getGeodeticOffset()));
-            program.setVec2("dayTextureGridSize", dayTexture->getTextureGridSize());
-            glBindTextureUnit(0, dayTexture->getTextureId());
-
-            // Set up night texture
-            program.setVec2("nightTextureGeodeticOffset", utils::convertToRads(nightTexture->getGeodeticOffset()));
-            program.setVec2("nightTextureGridSize", nightTexture->getTextureGridSize());
-            glBindTextureUnit(1, nightTexture->getTextureId());
-
-            // Set up height map
-            program.setVec2("heightMapGeodeticOffset", utils::convertToRads(heightMap->getGeodeticOffset()));
-            program.setVec2("heightMapGridSize", heightMap->getTextureGridSize());
-            glBindTextureUnit(2, heightMap->getTextureId());
-
-            // Set VAO: we need the correct buffer? Is there one or more?
-            glBindVertexArray(resources->meshVAO);
-
-            if (options.isWireframeEnabled) {
-                glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-            } else {
-                glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-            }
-            glDrawArrays(GL_PATCHES, 0, mesh.size());
-        }
+    // Keep the used textures in memory and request the missing ones, the most relevant first
+    updateTextureRelevance();
+    for (const std::shared_ptr<Texture> *texture: drawList.getUsedTextures()) {
+        prepareTexture(*texture);
     }
 
+    buildBatches(drawList);
+    uploadInstances();
+
+    if (options.isWireframeEnabled) {
+        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    } else {
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    }
+    program.setBool(uniforms.useProceduralGrid, options.isProceduralGridEnabled);
+    renderingStats.drawCalls = submitBatches(options.isProceduralGridEnabled);
+
     // TODO: refactor: extract method
     auto geodeticCameraPosition = ellipsoid.convertGeocentricToGeodetic(camera.getPosition());
     auto surfacePoint = ellipsoid.projectGeocentricPointOntoSurface(camera.getPosition());
@@ -261,37 +457,24 @@ void TileEarthRenderer::render(float currentTime, t_window_definition window, Re
     geodeticCameraPosition[1] *= -1; // Invert latitude (application uses a reversed latitude)
 
     renderingStats.loadedTextures = resourceManager.getNumLoadedTextures();
+    renderingStats.residentTextureBytes = resourceManager.getResidentBytes();
+    renderingStats.waitingTextures = loadedResults.size();
+    renderingStats.pendingRequests = resourceFetcher.getNumPendingRequests();
+    PixelBufferPoolStatistics pixelBufferStats = PixelBufferPool::getInstance().getStatistics();
+    renderingStats.pixelBufferHits = pixelBufferStats.hits;
+    renderingStats.pixelBufferMisses = pixelBufferStats.misses;
     renderingStats.cameraPosition = geodeticCameraPosition;
     renderingStats.renderedLatitudeRange = glm::vec2(minLatitude, maxLatitude);
     renderingStats.renderedLongitudeRange = glm::vec2(minLongitude, maxLongitude);
 
     for (auto &subscriber: subscribers) {
-        subscriber->notify(renderingStats);
+        subscriber->notify(renderingStats, visibleTiles);
     }
 }
 
-glm::mat4 TileEarthRenderer::constructPerspectiveProjectionMatrix(
-        const Camera &camera, const Ellipsoid &ellipsoid, const t_window_definition &window) {
-    // Near and far plane has to be determined from the distance to Earth
-    auto closestPointOnSurface = ellipsoid.projectGeocentricPointOntoSurface(camera.getPosition());
-    auto distanceToSurface = glm::length(camera.getPosition() - closestPointOnSurface);
-    auto distanceToEllipsoidsCenter = glm::length(camera.getPosition() - ellipsoid.getGeocentricPosition());
-
-    // The near plane is set in the middle of the camera position and the surface
-    auto nearPlane = static_cast<float>(distanceToSurface * 0.5);
-    auto farPlane = distanceToEllipsoidsCenter;
-
-    glm::mat4 projectionMatrix;
-    projectionMatrix = glm::perspective(glm::radians(camera.getFov()),
-                                        (float) window.width / (float) window.height,
-                                        nearPlane, farPlane);
-    return projectionMatrix;
-}
-
-
-Frustum TileEarthRenderer::setupMatrices(float currentTime, t_window_definition window) {
-    glm::mat4 projectionMatrix = constructPerspectiveProjectionMatrix(camera, ellipsoid, window);
-    glm::mat4 viewMatrix = camera.getViewMatrix();
+Frustum TileEarthRenderer::setupMatrices(float currentTime) {
+    const glm::mat4 &projectionMatrix = frameUniformBuffer.getProjectionMatrix();
+    const glm::mat4 &viewMatrix = frameUniformBuffer.getViewMatrix();
 
     // Do not rotate the model matrix to represent the Earth's inclination.
     // The inclination will be simulated using the position of the Sun
@@ -299,25 +482,28 @@ Frustum TileEarthRenderer::setupMatrices(float currentTime, t_window_definition
     //float inclinationAngle = glm::radians(23.5f); // Convert degrees to radians
     //modelMatrix = glm::rotate(modelMatrix, inclinationAngle, glm::vec3(1.0f, 0.0f, 0.0f));
 
-    program.setMat4("projection", projectionMatrix);
-    program.setMat4("view", viewMatrix);
-    program.setMat4("model", modelMatrix);
+    program.setMat4(uniforms.model, modelMatrix);
 
     return Frustum(viewMatrix, projectionMatrix);
 }
 
 void TileEarthRenderer::destroy() {
-    // Release textures
+    // Release textures. Pixels waiting for upload may point into the released staging buffer.
+    loadedResults.clear();
     resourceManager.releaseAll();
 
     // Release buffers
-    int numLevels = tileContainer.getNumLevels();
-    for (int level = 0; level < numLevels; level++) {
-        Tile &tile = tileContainer.getTiles()[0];
-        auto resources = tile.getResourcesByLevel(level);
-        glDeleteVertexArrays(1, &resources->meshVAO);
-        glDeleteBuffers(1, &resources->meshVBO);
+    for (const LevelMeshBuffers &meshBuffers: levelMeshes) {
+        if (meshBuffers.VAO != 0) {
+            glDeleteVertexArrays(1, &meshBuffers.VAO);
+            glDeleteBuffers(1, &meshBuffers.VBO);
+            glDeleteBuffers(1, &meshBuffers.EBO);
+        }
     }
+    glDeleteVertexArrays(1, &proceduralGridVAO);
+    glDeleteBuffers(1, &instanceVBO);
+    instanceBufferCapacity = 0;
+    levelMeshes.clear();
 }
 
 void TileEarthRenderer::addSubscriber(const std::shared_ptr<RendererSubscriber> &subscriber) {
@@ -17,52 +17,173 @@
 #include "RendererSubscriber.h"
 #include "../resources/ResourceFetcher.h"
 #include "../resources/ResourceManager.h"
-#include "../simulation/LightSource.h"
+#include "TileSelector.h"
+#include "FrameUniformBuffer.h"
+
+/**
+ * Per-instance attributes of a tile. The textures are described
+ * by their geodetic offset (in radians) and the size of their grid.
+ */
+struct TileInstance {
+    // Longitude offset, latitude offset, longitude width, latitude width in degrees
+    glm::vec4 tileBounds;
+    glm::vec4 dayTexture;
+    glm::vec4 nightTexture;
+    glm::vec4 heightMap;
+    // Layers of the day, night, and height texture arrays
+    glm::vec4 textureLayers;
+};
+
+/**
+ * Consecutive instances sharing the mesh and the texture arrays, drawn with a single draw call.
+ */
+struct TileBatch {
+    int level;
+    unsigned int dayTextureArray;
+    unsigned int nightTextureArray;
+    unsigned int heightMapArray;
+    unsigned int firstInstance;
+    unsigned int numInstances;
+};
+
+/**
+ * GPU buffers of the mesh shared by all tiles of a level of detail.
+ * They are created when the level is drawn from vertex buffers for the first time.
+ */
+struct LevelMeshBuffers {
+    unsigned int VAO = 0;
+    unsigned int VBO = 0;
+    unsigned int EBO = 0;
+    unsigned int numIndices = 0;
+    // GL_UNSIGNED_SHORT if all vertices can be addressed with 16 bits, GL_UNSIGNED_INT otherwise
+    GLenum indexType = GL_UNSIGNED_INT;
+};
+
+/**
+ * Locations of the uniforms of the tile program set every frame.
+ */
+struct TileUniformLocations {
+    UniformLocation dayTextureSampler = -1;
+    UniformLocation nightTextureSampler = -1;
+    UniformLocation heightMapSampler = -1;
+    UniformLocation useDayTexture = -1;
+    UniformLocation isNightEnabled = -1;
+    UniformLocation displayGrid = -1;
+    UniformLocation isTerrainEnabled = -1;
+    UniformLocation isTerrainShadingEnabled = -1;
+    UniformLocation gridResolution = -1;
+    UniformLocation gridLineWidth = -1;
+    UniformLocation blendDuration = -1;
+    UniformLocation blendDurationScale = -1;
+    UniformLocation heightDisplacementFactor = -1;
+    UniformLocation heightScale = -1;
+    UniformLocation model = -1;
+    UniformLocation useProceduralGrid = -1;
+    UniformLocation meshGridResolution = -1;
+};
 
 class TileEarthRenderer : public Renderer {
 private:
+    static const unsigned int maxSelectionThreads = 8;
+
     TileContainer &tileContainer;
     Camera &camera;
     Ellipsoid &ellipsoid;
     ResourceFetcher &resourceFetcher;
     ResourceManager &resourceManager;
-    const LightSource &lightSource;
+    const FrameUniformBuffer &frameUniformBuffer;
     Program &program;
+    TileUniformLocations uniforms;
     std::vector<std::shared_ptr<RendererSubscriber>> subscribers;
     std::unordered_map<std::string, std::shared_ptr<Texture>> requestMap;
+    // Textures loaded from disk that have not been moved into the OpenGL context yet
+    std::vector<TextureLoadResult> loadedResults;
+    // How much each wanted texture matters for the last selected view. It orders both
+    // the requests and the integration of loaded textures. Reused between frames.
+    std::unordered_map<const Texture *, float> textureRelevance;
+    // Vertex arrays of each level of detail
+    std::vector<LevelMeshBuffers> levelMeshes;
+    // Vertex array without vertex buffers used when the grid is generated in the vertex shader
+    unsigned int proceduralGridVAO = 0;
+    // Selects the tiles of the current frame and resolves their textures
+    TileSelector tileSelector;
+    // The terrain displacement the bounds of the tiles contain
+    double tileHeightDisplacement = 0;
+    // Instances of all batches of the current frame. The storage is reused between frames.
+    unsigned int instanceVBO = 0;
+    size_t instanceBufferCapacity = 0;
+    std::vector<TileDrawCommand> sortedCommands;
+    std::vector<TileInstance> instances;
+    std::vector<TileBatch> batches;
+
+
+    void resolveUniformLocations();
 
+    /**
+     * Returns the buffers of the level's mesh, creating them on the first use.
+     */
+    const LevelMeshBuffers &getLevelMeshBuffers(int level);
 
-    void initVertexArraysForAllLevels(int numLevels);
+    LevelMeshBuffers setupVertexArray(const TileMesh &tileMesh);
 
-    void setupVertexArray(std::vector<t_vertex> vertices,
-                          unsigned int &VAO, unsigned int &VBO);
+    /**
+     * Sets up the per-instance attributes of the bound vertex array.
+     */
+    void setupInstanceAttributes();
 
     bool prepareTexture(const std::shared_ptr<Texture>& texture);
 
-    Frustum setupMatrices(float currentTime, t_window_definition window);
+    Frustum setupMatrices(float currentTime);
+
+    /**
+     * Moves a loaded texture into the OpenGL context, taking over its pixels.
+     * @return The number of bytes uploaded.
+     */
+    size_t updateTextureWithData(TextureLoadResult &result);
+
+    /**
+     * Moves the loaded textures into the OpenGL context, the most relevant ones first,
+     * until the per-frame budget is spent. The rest is kept for the following frames.
+     */
+    void integrateLoadedTextures(const RenderingOptions &options);
+
+    /**
+     * Rates the textures of the selected tiles by their size on screen.
+     */
+    void updateTextureRelevance();
+
+    /**
+     * The relevance of the texture in the last rated frame, zero if it was not wanted.
+     */
+    [[nodiscard]] float getTextureRelevance(const Texture *texture) const;
 
-    glm::mat4 constructPerspectiveProjectionMatrix(
-            const Camera &camera, const Ellipsoid &ellipsoid, const t_window_definition &window);
+    /**
+     * Groups the draw commands by the level of detail and the texture arrays,
+     * and fills the per-instance attributes.
+     */
+    void buildBatches(const DrawList &drawList);
 
-    void updateTexturesWithData(const std::vector<TextureLoadResult> &results);
+    void uploadInstances();
 
-    bool getOrPrepareTexture(
-            const std::shared_ptr<TileResources> &resources,
-            const Tile &tile,
-            TextureType textureType,
-            std::shared_ptr<Texture> &texture);
+    /**
+     * Draws all batches with one instanced draw call each.
+     * @param useProceduralGrid Generate the grid from the vertex ID instead of reading vertex buffers.
+     * @return The number of draw calls.
+     */
+    unsigned int submitBatches(bool useProceduralGrid);
 public:
     explicit TileEarthRenderer(TileContainer &tileContainer,
                                Ellipsoid &ellipsoid,
                                Camera &camera,
-                               LightSource &lightSource,
+                               const FrameUniformBuffer &frameUniformBuffer,
                                ResourceFetcher &resourceFetcher,
                                ResourceManager &resourceManager,
                                Program &program)
             : tileContainer(tileContainer), camera(camera), ellipsoid(ellipsoid),
-              lightSource(lightSource), resourceFetcher(resourceFetcher),
+              frameUniformBuffer(frameUniformBuffer), resourceFetcher(resourceFetcher),
               resourceManager(resourceManager),
-              program(program) {
+              program(program),
+              tileSelector(tileContainer, ThreadPool::getDefaultNumThreads(maxSelectionThreads)) {
     }
 
     void render(float currentTime, t_window_definition window, RenderingOptions options) override;
@@ -0,0 +1,274 @@
+#include "TileSelector.h"
+#include <cmath>
+#include <limits>
+
+void TileSelector::select(const Frustum &frustum, const Camera &camera, const Ellipsoid &ellipsoid,
+                          const t_window_definition &window, unsigned long texturesVersion,
+                          const RenderingOptions &options, RenderingStatistics &renderingStats) {
+    FrustumCuller frustumCuller(frustum);
+    EllipsoidalOccluder occluder(ellipsoid, camera.getPosition());
+
+    // The orientation of the camera from the rows of the view matrix
+    glm::mat4 viewMatrix = camera.getViewMatrix();
+    glm::vec3 cameraUp(viewMatrix[0][1], viewMatrix[1][1], viewMatrix[2][1]);
+    glm::vec3 cameraForward(-viewMatrix[0][2], -viewMatrix[1][2], -viewMatrix[2][2]);
+    FrameParameters parameters{frustum, frustumCuller, occluder, camera,
+                               camera.getPosition(), cameraForward, cameraUp,
+                               static_cast<double>(window.width), options.isCullingEnabled};
+
+    FrameKey frameKey{window.width, window.height, camera.getFov(), options.isCullingEnabled};
+    if (!(frameKey == lastFrameKey)) {
+        invalidate();
+        lastFrameKey = frameKey;
+    }
+
+    // Sitting on a view, the previous selection is still valid as a whole.
+    bool isCameraStill = hasLastFrame &&
+                         parameters.cameraPosition == lastCameraPosition &&
+                         cameraForward == lastCameraForward &&
+                         cameraUp == lastCameraUp;
+    if (isCameraStill) {
+        lastSelectionStatistics.reusedTiles = lastSelectionStatistics.visitedTiles;
+        lastSelectionStatistics.reevaluatedTiles = 0;
+    } else {
+        lastSelectionStatistics = RenderingStatistics();
+        traverseQuadtree(parameters, lastSelectionStatistics);
+    }
+    renderingStats.visitedTiles += lastSelectionStatistics.visitedTiles;
+    renderingStats.frustumCulledTiles += lastSelectionStatistics.frustumCulledTiles;
+    renderingStats.horizonCulledTiles += lastSelectionStatistics.horizonCulledTiles;
+    renderingStats.reevaluatedTiles += lastSelectionStatistics.reevaluatedTiles;
+    renderingStats.reusedTiles += lastSelectionStatistics.reusedTiles;
+
+    // The draw commands change only with the selected tiles or the ready textures.
+    bool isDrawListValid = isCameraStill && texturesVersion == lastTexturesVersion;
+    hasLastFrame = true;
+    lastCameraPosition = parameters.cameraPosition;
+    lastCameraForward = cameraForward;
+    lastCameraUp = cameraUp;
+    lastTexturesVersion = texturesVersion;
+    if (isDrawListValid) {
+        return;
+    }
+
+    // Resolve the textures of the selected tiles
+    size_t numChunks = getNumChunks(visibleTiles.size());
+    if (chunks.size() < numChunks) {
+        chunks.resize(numChunks);
+    }
+    threadPool.parallelFor(numChunks, [this](size_t chunkIndex) {
+        DrawList &chunkDrawList = chunks[chunkIndex].drawList;
+        chunkDrawList.clear();
+        size_t end = std::min((chunkIndex + 1) * chunkSize, visibleTiles.size());
+        for (size_t i = chunkIndex * chunkSize; i < end; i++) {
+            resolveDrawCommands(visibleTiles[i].tileIndex, chunkDrawList);
+        }
+    });
+    drawList.clear();
+    for (size_t chunkIndex = 0; chunkIndex < numChunks; chunkIndex++) {
+        drawList.append(chunks[chunkIndex].drawList);
+    }
+}
+
+void TileSelector::traverseQuadtree(const FrameParameters &parameters, RenderingStatistics &selectionStats) {
+    size_t numTiles = tileContainer.getTileBounds().size();
+    if (decisionCache.size() != numTiles) {
+        decisionCache.assign(numTiles, CachedDecision());
+    }
+
+    visibleTiles.clear();
+    candidateTiles.clear();
+    for (unsigned int rootIndex = 0; rootIndex < tileContainer.getNumRootTiles(); rootIndex++) {
+        candidateTiles.push_back(rootIndex);
+    }
+
+    while (!candidateTiles.empty()) {
+        size_t numChunks = getNumChunks(candidateTiles.size());
+        if (chunks.size() < numChunks) {
+            chunks.resize(numChunks);
+        }
+        threadPool.parallelFor(numChunks, [this, &parameters](size_t chunkIndex) {
+            selectTilesInChunk(parameters, chunkIndex);
+        });
+
+        // Merge the outputs in the order of the chunks
+        candidateTiles.clear();
+        for (size_t chunkIndex = 0; chunkIndex < numChunks; chunkIndex++) {
+            const Chunk &chunk = chunks[chunkIndex];
+            candidateTiles.insert(candidateTiles.end(),
+                                  chunk.nextCandidateTiles.begin(), chunk.nextCandidateTiles.end());
+            visibleTiles.append(chunk.selectedTiles);
+            selectionStats.visitedTiles += chunk.statistics.visitedTiles;
+            selectionStats.frustumCulledTiles += chunk.statistics.frustumCulledTiles;
+            selectionStats.horizonCulledTiles += chunk.statistics.horizonCulledTiles;
+            selectionStats.reevaluatedTiles += chunk.statistics.reevaluatedTiles;
+            selectionStats.reusedTiles += chunk.statistics.reusedTiles;
+        }
+    }
+}
+
+void TileSelector::selectTilesInChunk(const FrameParameters &parameters, size_t chunkIndex) {
+    Chunk &chunk = chunks[chunkIndex];
+    chunk.nextCandidateTiles.clear();
+    chunk.selectedTiles.clear();
+    chunk.statistics = RenderingStatistics();
+
+    size_t begin = chunkIndex * chunkSize;
+    size_t count = std::min(chunkSize, candidateTiles.size() - begin);
+    const unsigned int *chunkCandidates = candidateTiles.data() + begin;
+
+    // Only the tiles without a valid cached decision are evaluated
+    chunk.evaluatedPositions.clear();
+    chunk.evaluatedTiles.clear();
+    for (unsigned int i = 0; i < count; i++) {
+        if (!isCachedDecisionValid(decisionCache[chunkCandidates[i]], parameters)) {
+            chunk.evaluatedPositions.push_back(i);
+            chunk.evaluatedTiles.push_back(chunkCandidates[i]);
+        }
+    }
+
+    // Frustum culling of all evaluated tiles of this chunk at once
+    if (parameters.isCullingEnabled && !chunk.evaluatedTiles.empty()) {
+        parameters.frustumCuller.cullTiles(tileContainer.getTileBounds(), chunk.evaluatedTiles.data(),
+                                           chunk.evaluatedTiles.size(), chunk.visibilityMask);
+    }
+
+    size_t evaluatedIndex = 0;
+    for (unsigned int i = 0; i < count; i++) {
+        unsigned int tileIndex = chunkCandidates[i];
+        const Tile &tile = tileContainer.getTile(tileIndex);
+        CachedDecision &cached = decisionCache[tileIndex];
+        chunk.statistics.visitedTiles++;
+
+        TileDecision decision;
+        if (evaluatedIndex < chunk.evaluatedPositions.size() && chunk.evaluatedPositions[evaluatedIndex] == i) {
+            bool isInFrustum = !parameters.isCullingEnabled ||
+                               FrustumCuller::isVisible(chunk.visibilityMask, evaluatedIndex);
+            decision = evaluateTile(tile, isInFrustum, parameters);
+            cacheDecision(tile, decision, parameters, cached);
+            evaluatedIndex++;
+            chunk.statistics.reevaluatedTiles++;
+        } else {
+            decision = cached.decision;
+            chunk.statistics.reusedTiles++;
+        }
+
+        switch (decision) {
+            case TileDecision::FrustumCulled:
+                // If a tile is culled, none of its children can be visible.
+                chunk.statistics.frustumCulledTiles++;
+                break;
+            case TileDecision::HorizonCulled:
+                chunk.statistics.horizonCulledTiles++;
+                break;
+            case TileDecision::Refined:
+                for (unsigned int child = 0; child < tile.getNumChildren(); child++) {
+                    chunk.nextCandidateTiles.push_back(tile.getFirstChildIndex() + child);
+                }
+                break;
+            case TileDecision::Selected:
+                chunk.selectedTiles.add(tileIndex, tile.getLevel());
+                break;
+        }
+    }
+}
+
+TileSelector::TileDecision TileSelector::evaluateTile(const Tile &tile, bool isInFrustum,
+                                                      const FrameParameters &parameters) const {
+    if (parameters.isCullingEnabled) {
+        if (!isInFrustum) {
+            return TileDecision::FrustumCulled;
+        }
+        if (!tile.isAboveHorizon(parameters.occluder)) {
+            return TileDecision::HorizonCulled;
+        }
+    }
+    // Visit the children only if this tile is too coarse for the current view
+    if (tile.isRefinementNeeded(parameters.screenSpaceWidth, parameters.camera)) {
+        return TileDecision::Refined;
+    }
+    return TileDecision::Selected;
+}
+
+bool TileSelector::isCachedDecisionValid(const CachedDecision &cached, const FrameParameters &parameters) const {
+    if (cached.epoch != epoch) {
+        return false;
+    }
+    glm::vec3 movement = parameters.cameraPosition - cached.cameraPosition;
+    if (glm::dot(movement, movement) > cached.positionTolerance * cached.positionTolerance) {
+        return false;
+    }
+    return glm::dot(parameters.cameraForward, cached.cameraForward) >= cached.minRotationCosine &&
+           glm::dot(parameters.cameraUp, cached.cameraUp) >= cached.minRotationCosine;
+}
+
+void TileSelector::cacheDecision(const Tile &tile, TileDecision decision, const FrameParameters &parameters,
+                                 CachedDecision &cached) const {
+    glm::vec3 sphereCentre = tile.getBoundingSphereCentre();
+    auto sphereRadius = static_cast<float>(tile.getTileRadius());
+    float centreDistance = glm::length(sphereCentre - parameters.cameraPosition);
+    float distance = std::max(centreDistance - sphereRadius, 0.0f);
+
+    // The screen-space error and the horizon change with the relative distance to the tile.
+    float positionTolerance = distanceTolerance * distance;
+    float rotationTolerance = std::numeric_limits<float>::infinity();
+    if (parameters.isCullingEnabled) {
+        // Moving the camera by d moves the frustum planes by at most 2d, as the near and far
+        // planes follow the distance to the surface. Rotating the camera by an angle a moves
+        // the tile relative to the planes by at most a times its farthest distance. Forward
+        // and up vectors are compared separately, so half of the angle is allowed for each.
+        float margin = parameters.frustum.getSphereMargin(sphereCentre, sphereRadius);
+        positionTolerance = std::min(positionTolerance, margin / 2.0f);
+        rotationTolerance = margin / (2.0f * (centreDistance + sphereRadius));
+    }
+
+    cached.epoch = epoch;
+    cached.decision = decision;
+    cached.cameraPosition = parameters.cameraPosition;
+    cached.cameraForward = parameters.cameraForward;
+    cached.cameraUp = parameters.cameraUp;
+    cached.positionTolerance = positionTolerance;
+    cached.minRotationCosine = rotationTolerance < M_PI ? std::cos(rotationTolerance) : -1.0f;
+}
+
+void TileSelector::resolveDrawCommands(unsigned int tileIndex, DrawList &chunkDrawList) const {
+    const Tile &tile = tileContainer.getTile(tileIndex);
+    const TileResources &resources = *tile.getResources();
+
+    // The textures of this tile are wanted in any case. Each of them has to be prepared.
+    chunkDrawList.addUsedTexture(resources.getTexture(TextureType::Day));
+    chunkDrawList.addUsedTexture(resources.getTexture(TextureType::Night));
+    chunkDrawList.addUsedTexture(resources.getTexture(TextureType::HeightMap));
+
+    // When zooming out, the textures of the children are typically still loaded.
+    if (!resources.isPreparedInGlContext() && resources.areFinerResourcesPrepared()) {
+        for (unsigned int i = 0; i < tile.getNumChildren(); i++) {
+            resolveDrawCommands(tile.getFirstChildIndex() + i, chunkDrawList);
+        }
+        return;
+    }
+
+    TileDrawCommand command{
+            tileIndex,
+            findReadyTexture(resources, TextureType::Day),
+            findReadyTexture(resources, TextureType::Night),
+            findReadyTexture(resources, TextureType::HeightMap)
+    };
+    // Draw only if the necessary resources are ready
+    if (command.dayTexture == nullptr || command.nightTexture == nullptr || command.heightMap == nullptr) {
+        return;
+    }
+    chunkDrawList.addCommand(command);
+}
+
+Texture *TileSelector::findReadyTexture(const TileResources &resources, TextureType textureType) {
+    const TileResources *current = &resources;
+    while (current != nullptr) {
+        Texture *texture = current->getTexture(textureType).get();
+        if (texture->isPreparedInGlContext()) {
+            return texture;
+        }
+        current = current->coarserResources.get();
+    }
+    return nullptr;
+}
@@ -0,0 +1,177 @@
+#ifndef EARTH_VISUALIZATION_TILESELECTOR_H
+#define EARTH_VISUALIZATION_TILESELECTOR_H
+
+#include <vector>
+#include <cstdint>
+#include "VisibleTiles.h"
+#include "DrawList.h"
+#include "RenderingOptions.h"
+#include "RendererSubscriber.h"
+#include "../window_definition.h"
+#include "../tiling/TileContainer.h"
+#include "../culling/FrustumCuller.h"
+#include "../culling/EllipsoidalOccluder.h"
+#include "../threading/ThreadPool.h"
+
+/**
+ * The CPU part of rendering the tiles: culling, selection of the levels of detail,
+ * and resolution of the textures to draw with. It does not call OpenGL.
+ *
+ * The work is split into chunks of tiles processed on a thread pool. The outputs
+ * of the chunks are concatenated in the order of the chunks, so the results do
+ * not depend on the number of threads.
+ *
+ * The decisions about the tiles are cached between frames. A decision is reused
+ * until the camera moves or rotates by more than a tolerance derived from the bounds
+ * of the tile, or until the window size, the field of view, or the options change.
+ */
+class TileSelector {
+private:
+    // The number of tiles processed by a single task. A multiple of the culling batch size.
+    static const size_t chunkSize = 256;
+
+    /**
+     * The camera may move by this fraction of its distance from a tile before the LOD
+     * and horizon decisions are re-evaluated. The screen-space error changes by about as much.
+     */
+    static constexpr float distanceTolerance = 0.01f;
+
+    enum class TileDecision : uint8_t {
+        FrustumCulled, HorizonCulled, Refined, Selected
+    };
+
+    struct CachedDecision {
+        // The decision is valid only in the epoch it was made in.
+        unsigned int epoch = 0;
+        TileDecision decision = TileDecision::Selected;
+        glm::vec3 cameraPosition;
+        glm::vec3 cameraForward;
+        glm::vec3 cameraUp;
+        float positionTolerance = 0;
+        // Cosine of the largest allowed rotation of the camera
+        float minRotationCosine = 1;
+    };
+
+    /**
+     * Outputs of a single task. The storage is reused between frames.
+     */
+    struct Chunk {
+        std::vector<unsigned int> nextCandidateTiles;
+        // Positions of the candidates in this chunk which have to be re-evaluated, and their tiles
+        std::vector<unsigned int> evaluatedPositions;
+        std::vector<unsigned int> evaluatedTiles;
+        std::vector<uint8_t> visibilityMask;
+        VisibleTiles selectedTiles;
+        DrawList drawList;
+        RenderingStatistics statistics;
+    };
+
+    /**
+     * Parameters of the current frame shared by all tasks.
+     */
+    struct FrameParameters {
+        const Frustum &frustum;
+        const FrustumCuller &frustumCuller;
+        const EllipsoidalOccluder &occluder;
+        const Camera &camera;
+        glm::vec3 cameraPosition;
+        glm::vec3 cameraForward;
+        glm::vec3 cameraUp;
+        double screenSpaceWidth;
+        bool isCullingEnabled;
+    };
+
+    /**
+     * Everything the cached decisions depend on, except for the camera pose.
+     */
+    struct FrameKey {
+        int windowWidth = 0;
+        int windowHeight = 0;
+        float fov = 0;
+        bool isCullingEnabled = false;
+
+        bool operator==(const FrameKey &other) const {
+            return windowWidth == other.windowWidth && windowHeight == other.windowHeight &&
+                   fov == other.fov && isCullingEnabled == other.isCullingEnabled;
+        }
+    };
+
+    const TileContainer &tileContainer;
+    ThreadPool threadPool;
+    std::vector<Chunk> chunks;
+    // Tiles to be classified at the current depth of the quadtree
+    std::vector<unsigned int> candidateTiles;
+    VisibleTiles visibleTiles;
+    DrawList drawList;
+
+    std::vector<CachedDecision> decisionCache;
+    // Incremented to invalidate all cached decisions at once. The cache starts in the epoch 0.
+    unsigned int epoch = 1;
+    FrameKey lastFrameKey;
+    glm::vec3 lastCameraPosition;
+    glm::vec3 lastCameraForward;
+    glm::vec3 lastCameraUp;
+    RenderingStatistics lastSelectionStatistics;
+    unsigned long lastTexturesVersion = 0;
+    bool hasLastFrame = false;
+
+    static size_t getNumChunks(size_t numItems) {
+        return (numItems + chunkSize - 1) / chunkSize;
+    }
+
+    void traverseQuadtree(const FrameParameters &parameters, RenderingStatistics &selectionStats);
+
+    void selectTilesInChunk(const FrameParameters &parameters, size_t chunkIndex);
+
+    [[nodiscard]] bool isCachedDecisionValid(const CachedDecision &cached, const FrameParameters &parameters) const;
+
+    [[nodiscard]] TileDecision evaluateTile(const Tile &tile, bool isInFrustum, const FrameParameters &parameters) const;
+
+    void cacheDecision(const Tile &tile, TileDecision decision, const FrameParameters &parameters,
+                       CachedDecision &cached) const;
+
+    void resolveDrawCommands(unsigned int tileIndex, DrawList &chunkDrawList) const;
+
+    /**
+     * Finds a texture of the given type which is ready in OpenGL context,
+     * either of the given resources or of the coarser ones.
+     */
+    static Texture *findReadyTexture(const TileResources &resources, TextureType textureType);
+
+public:
+    TileSelector(const TileContainer &tileContainer, unsigned int numThreads)
+            : tileContainer(tileContainer), threadPool(numThreads) {
+    }
+
+    /**
+     * Traverses the quadtree of tiles breadth-first. All candidates of the same depth
+     * are culled in parallel. Culled tiles are skipped with all their children,
+     * and the children are visited only if the tile needs refinement.
+     * Then, the draw commands of the selected tiles are resolved.
+     *
+     * @param texturesVersion Changes whenever a texture becomes ready or is released,
+     * so that the draw commands have to be resolved again.
+     */
+    void select(const Frustum &frustum, const Camera &camera, const Ellipsoid &ellipsoid,
+                const t_window_definition &window, unsigned long texturesVersion,
+                const RenderingOptions &options, RenderingStatistics &renderingStats);
+
+    /**
+     * Forgets all cached decisions, e.g., after the tiles have changed.
+     */
+    void invalidate() {
+        epoch++;
+        hasLastFrame = false;
+    }
+
+    [[nodiscard]] const VisibleTiles &getVisibleTiles() const {
+        return visibleTiles;
+    }
+
+    [[nodiscard]] const DrawList &getDrawList() const {
+        return drawList;
+    }
+};
+
+
+#endif //EARTH_VISUALIZATION_TILESELECTOR_H
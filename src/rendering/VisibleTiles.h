@@ -0,0 +1,61 @@
+#ifndef EARTH_VISUALIZATION_VISIBLETILES_H
+#define EARTH_VISUALIZATION_VISIBLETILES_H
+
+#include <vector>
+#include <cstddef>
+
+struct VisibleTile {
+    // Index of the tile in the tile container
+    unsigned int tileIndex;
+    // The selected level of detail
+    int level;
+};
+
+/**
+ * The tiles selected for rendering in the current frame.
+ *
+ * The storage is kept between frames. Once it has grown to the number
+ * of tiles typically visible, no further allocations take place.
+ */
+class VisibleTiles {
+private:
+    std::vector<VisibleTile> tiles;
+
+public:
+    /**
+     * Forgets the tiles of the previous frame, keeping the allocated storage.
+     */
+    void clear() {
+        tiles.clear();
+    }
+
+    void add(unsigned int tileIndex, int level) {
+        tiles.push_back({tileIndex, level});
+    }
+
+    void append(const VisibleTiles &other) {
+        tiles.insert(tiles.end(), other.tiles.begin(), other.tiles.end());
+    }
+
+    [[nodiscard]] size_t size() const {
+        return tiles.size();
+    }
+
+    [[nodiscard]] bool empty() const {
+        return tiles.empty();
+    }
+
+    [[nodiscard]] const VisibleTile &operator[](size_t index) const {
+        return tiles[index];
+    }
+
+    [[nodiscard]] std::vector<VisibleTile>::const_iterator begin() const {
+        return tiles.begin();
+    }
+
+    [[nodiscard]] std::vector<VisibleTile>::const_iterator end() const {
+        return tiles.end();
+    }
+};
+
+#endif //EARTH_VISUALIZATION_VISIBLETILES_H
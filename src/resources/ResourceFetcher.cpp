@@ -3,10 +3,159 @@
 //
 
 #include "ResourceFetcher.h"
+#include <algorithm>
 
-std::queue<TextureLoadRequest> loadingTexturesQueue;
-std::deque<TextureLoadResult> resultsQueue;
-std::mutex loadingMutex;
-std::mutex resultsMutex;
-std::condition_variable cv;
-std::atomic<bool> stopThread(false);
+// Finished textures the requester has not picked up yet. Workers wait if it fills up.
+static const size_t resultsCapacity = 256;
+// Requests handed to each worker in advance
+static const size_t dispatchedRequestsPerWorker = 2;
+
+ResourceFetcher::ResourceFetcher(unsigned int numWorkers, unsigned int maxRequestAge)
+        : maxRequestAge(maxRequestAge),
+          dispatchedRequests(std::max(numWorkers, 1u) * dispatchedRequestsPerWorker),
+          results(resultsCapacity) {
+    numWorkers = std::max(numWorkers, 1u);
+    for (unsigned int i = 0; i < numWorkers; i++) {
+        workers.emplace_back(&ResourceFetcher::workerLoop, this);
+    }
+}
+
+ResourceFetcher::~ResourceFetcher() {
+    stop();
+}
+
+void ResourceFetcher::stop() {
+    isStopping = true;
+    requests.clear();
+    queue.clear();
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        requestAvailable.notify_all();
+    }
+    for (std::thread &worker: workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void ResourceFetcher::workerLoop() {
+    ResourceLoader loader;
+    while (!isStopping) {
+        TextureLoadRequest request;
+        if (!dispatchedRequests.tryPop(request)) {
+            // The requester pushes before taking the mutex to notify, so the check
+            // under the mutex either sees the request or the notification follows.
+            std::unique_lock<std::mutex> lock(idleMutex);
+            requestAvailable.wait(lock, [this] {
+                return isStopping || !dispatchedRequests.isEmpty();
+            });
+            continue;
+        }
+
+        // Load the texture data from file
+        TextureLoadResult result;
+        loader.load(request, result);
+
+        // Hand the result over to the requester
+        while (!results.tryPush(result)) {
+            if (isStopping) {
+                return;
+            }
+            std::this_thread::sleep_for(fullResultsTimeout);
+        }
+    }
+}
+
+void ResourceFetcher::enqueue(const PendingRequest &pending) {
+    queue.push_back({pending.request.priority, pending.sequenceNumber, pending.request.path});
+    std::push_heap(queue.begin(), queue.end());
+
+    // Priorities are updated every frame, which would grow the heap without bounds
+    if (queue.size() > 2 * requests.size() + 64) {
+        queue.clear();
+        for (const auto &[path, other]: requests) {
+            queue.push_back({other.request.priority, other.sequenceNumber, path});
+        }
+        std::make_heap(queue.begin(), queue.end());
+    }
+}
+
+void ResourceFetcher::dispatchRequests() {
+    bool isDispatched = false;
+    while (!queue.empty()) {
+        const QueuedRequest &mostUrgent = queue.front();
+        auto it = requests.find(mostUrgent.path);
+        // Skip the requests cancelled or dispatched since, and the outdated priorities
+        bool isOutdated = it == requests.end() || it->second.request.priority != mostUrgent.priority;
+        if (!isOutdated) {
+            if (!dispatchedRequests.tryPush(it->second.request)) {
+                break;
+            }
+            requests.erase(it);
+            isDispatched = true;
+        }
+        std::pop_heap(queue.begin(), queue.end());
+        queue.pop_back();
+    }
+
+    if (isDispatched) {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        requestAvailable.notify_all();
+    }
+}
+
+void ResourceFetcher::request(const TextureLoadRequest &job) {
+    if (isStopping) {
+        return;
+    }
+    if (!updatePriority(job.path, job.priority)) {
+        auto it = requests.emplace(job.path, PendingRequest{job, currentFrame, nextSequenceNumber++}).first;
+        enqueue(it->second);
+    }
+    dispatchRequests();
+}
+
+bool ResourceFetcher::updatePriority(const std::string &path, float priority) {
+    auto it = requests.find(path);
+    if (it == requests.end()) {
+        return false;
+    }
+    it->second.lastAssertedFrame = currentFrame;
+    if (it->second.request.priority != priority) {
+        it->second.request.priority = priority;
+        enqueue(it->second);
+    }
+    return true;
+}
+
+std::vector<std::string> ResourceFetcher::advanceFrame() {
+    std::vector<std::string> cancelledPaths;
+    currentFrame++;
+    for (auto it = requests.begin(); it != requests.end();) {
+        if (currentFrame - it->second.lastAssertedFrame > maxRequestAge) {
+            cancelledPaths.push_back(it->first);
+            it = requests.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    dispatchRequests();
+    return cancelledPaths;
+}
+
+std::vector<TextureLoadResult> ResourceFetcher::retrieveLoadedResources() {
+    std::vector<TextureLoadResult> finishedResults;
+    TextureLoadResult result;
+    while (results.tryPop(result)) {
+        finishedResults.push_back(std::move(result));
+    }
+    // The workers that returned the results have room for more requests
+    dispatchRequests();
+    return finishedResults;
+}
+
+unsigned int ResourceFetcher::getDefaultNumWorkers() {
+    unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+}
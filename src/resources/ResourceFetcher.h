@@ -6,16 +6,31 @@
 #define EARTH_VISUALIZATION_RESOURCEFETCHER_H
 
 #include <iostream>
-#include <queue>
+#include <unordered_map>
+#include <vector>
 #include <thread>
 #include <mutex>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <memory>
+#include <cstring>
 #include "../textures/Texture.h"
+#include "../textures/PixelUploadRing.h"
+#include "../textures/PixelData.h"
+#include "../textures/MipChain.h"
+#include "../threading/BoundedRing.h"
 
 struct TextureLoadRequest {
+    // Identifies the texture. It is the path of the image file unless the texture comes from a pack.
     std::string path;
+    // Where to put the decoded pixels. If not set or full, they are returned in the result's data.
+    std::shared_ptr<PixelUploadRing> stagingRing;
+    // Requests with a higher priority are decoded first
+    float priority = 0;
+    // The pack and the tile to read the pixels from instead of decoding the file
+    std::shared_ptr<const TilePack> pack;
+    unsigned int packTileIndex = 0;
 };
 
 struct TextureLoadResult {
@@ -23,57 +38,119 @@ struct TextureLoadResult {
     int width = 0;
     int height = 0;
     int channels = 0;
-    std::vector<unsigned char> data;
-};
+    // The number of mipmap levels of the texture, including the base level
+    int numMipLevels = 1;
+    // The base level, owned by the result and passed on to the texture without copying
+    PixelData data;
+    // The remaining levels one after another, passed on the same way. Not set if there are none.
+    PixelData mipLevels;
+    // The whole mip chain copied into the staging ring, used instead of the buffers if valid
+    PixelUploadRegion stagedPixels;
 
-extern std::queue<TextureLoadRequest> loadingTexturesQueue;
-extern std::deque<TextureLoadResult> resultsQueue;
-extern std::mutex loadingMutex;
-extern std::mutex resultsMutex;
-extern std::condition_variable cv;
-extern std::atomic<bool> stopThread;
+    TextureLoadResult() = default;
 
-class ResourceLoader {
-public:
-    void start() {
-        while (true) {
-            std::unique_lock<std::mutex> lock(loadingMutex);
-            cv.wait(lock, [] { return !loadingTexturesQueue.empty() || stopThread; });
+    // Results are only ever moved between the threads
+    TextureLoadResult(TextureLoadResult &&) = default;
 
-            if (stopThread) {
-                break;
-            }
+    TextureLoadResult &operator=(TextureLoadResult &&) = default;
 
-            TextureLoadRequest request = loadingTexturesQueue.front();
-            loadingTexturesQueue.pop();
-            lock.unlock();
+    TextureLoadResult(const TextureLoadResult &) = delete;
 
-            // Load the texture data from file
-            TextureLoadResult result;
-            load(request, result);
+    TextureLoadResult &operator=(const TextureLoadResult &) = delete;
+};
 
-            // Push the result to the results queue for the main thread
-            {
-                std::lock_guard<std::mutex> resultLock(resultsMutex);
-                resultsQueue.push_back(result);
-            }
+/**
+ * Decodes textures from files, or reads them from tile packs, together with their mipmaps.
+ * Each worker has its own loader.
+ */
+class ResourceLoader {
+private:
+    static PixelData allocatePixels(size_t size) {
+        return PixelData(static_cast<unsigned char *>(PixelBufferPool::getInstance().allocate(size)));
+    }
+
+    /**
+     * Copies the base level and the remaining levels into the staging ring if it has room.
+     * @return False if the pixels have to be returned in the result's buffers instead.
+     */
+    static bool stagePixels(const TextureLoadRequest &request, const unsigned char *baseLevel, size_t baseSize,
+                            const unsigned char *mipLevels, size_t mipLevelsSize, TextureLoadResult &result) {
+        if (!request.stagingRing) {
+            return false;
+        }
+        result.stagedPixels = request.stagingRing->reserve(baseSize + mipLevelsSize);
+        if (!result.stagedPixels.isValid()) {
+            return false;
+        }
+        std::memcpy(result.stagedPixels.data, baseLevel, baseSize);
+        if (mipLevelsSize > 0) {
+            std::memcpy(result.stagedPixels.data + baseSize, mipLevels, mipLevelsSize);
         }
+        request.stagingRing->finishWriting();
+        return true;
     }
 
+    /**
+     * Reads a tile with its mip chain from a pack. The pages of the pack are touched
+     * here rather than on the render thread.
+     */
+    static void loadFromPack(const TextureLoadRequest &request, TextureLoadResult &result) {
+        const TilePack &pack = *request.pack;
+        const TilePackEntry &entry = pack.getEntry(request.packTileIndex);
+        result.path = request.path;
+        result.width = static_cast<int>(entry.width);
+        result.height = static_cast<int>(entry.height);
+        result.channels = static_cast<int>(entry.channels);
+        result.numMipLevels = static_cast<int>(entry.numMipLevels);
+
+        const unsigned char *baseLevel = pack.getMipLevel(request.packTileIndex, 0);
+        size_t baseSize = BlockCompression::getLevelSize(pack.getCompression(), result.width, result.height,
+                                                         result.channels, 0);
+        size_t mipLevelsSize = entry.size - baseSize;
+        if (stagePixels(request, baseLevel, baseSize, baseLevel + baseSize, mipLevelsSize, result)) {
+            return;
+        }
+        result.data = allocatePixels(baseSize);
+        std::memcpy(result.data.get(), baseLevel, baseSize);
+        if (mipLevelsSize > 0) {
+            result.mipLevels = allocatePixels(mipLevelsSize);
+            std::memcpy(result.mipLevels.get(), baseLevel + baseSize, mipLevelsSize);
+        }
+    }
+
+public:
     void load(const TextureLoadRequest &request, TextureLoadResult &result) {
+        if (request.pack) {
+            loadFromPack(request, result);
+            return;
+        }
+
         int width, height, channels;
         // stbi_set_flip_vertically_on_load(true);
-        unsigned char *data = stbi_load(request.path.c_str(),
-                                        &width, &height, &channels, 0);
+        PixelData data(stbi_load(request.path.c_str(), &width, &height, &channels, 0));
 
         if (data) {
             result.path = request.path;
             result.width = width;
             result.height = height;
             result.channels = channels;
-            result.data = std::vector<unsigned char>(data, data + width * height * channels);
 
-            stbi_image_free(data);
+            // The render thread only uploads the levels. They are built in cached memory
+            // rather than in the staging ring, which is slow to read from.
+            result.numMipLevels = MipChain::getNumLevels(width, height);
+            size_t baseSize = MipChain::getLevelSize(width, height, channels, 0);
+            size_t mipLevelsSize = MipChain::getChainSize(width, height, channels, result.numMipLevels) - baseSize;
+            PixelData mipLevels;
+            if (mipLevelsSize > 0) {
+                mipLevels = allocatePixels(mipLevelsSize);
+                MipChain::buildLevels(data.get(), width, height, channels, result.numMipLevels, mipLevels.get());
+            }
+
+            // Preferably into memory the GPU reads from, otherwise the buffers are handed over
+            if (!stagePixels(request, data.get(), baseSize, mipLevels.get(), mipLevelsSize, result)) {
+                result.data = std::move(data);
+                result.mipLevels = std::move(mipLevels);
+            }
         } else {
             std::cout << "Failed to load texture: " << request.path << std::endl;
         }
@@ -81,42 +158,137 @@ public:
 
 };
 
+/**
+ * Loads textures from disk on a pool of worker threads.
+ *
+ * Each instance owns its queues and workers, so independent instances can
+ * serve separate datasets. The workers start with the instance and are
+ * joined when it is destroyed.
+ *
+ * The requester re-asserts the requests it still needs every frame; those not
+ * re-asserted for maxRequestAge frames are cancelled before being decoded.
+ * Pending requests are ordered by their priority in a heap. Whenever requests
+ * arrive or results are picked up, the most urgent ones are handed to the
+ * workers through a short lock-free ring, and the workers return the results
+ * through another one. The requesting thread never waits for a worker.
+ * All methods except the constructor and stop must be called from the same thread.
+ */
 class ResourceFetcher {
 private:
-public:
-    void request(const TextureLoadRequest& job) {
-        {
-            std::lock_guard<std::mutex> lock(loadingMutex);
-            loadingTexturesQueue.push(job);
+    struct PendingRequest {
+        TextureLoadRequest request;
+        unsigned long lastAssertedFrame;
+        // Orders requests of the same priority by their arrival
+        unsigned long sequenceNumber;
+    };
+
+    /**
+     * An entry of the heap of pending requests. Changing the priority of a request adds
+     * another entry; those no longer matching the request are skipped when they surface.
+     */
+    struct QueuedRequest {
+        float priority;
+        unsigned long sequenceNumber;
+        std::string path;
+
+        /**
+         * Orders the heap so that the most urgent request is at its top.
+         */
+        bool operator<(const QueuedRequest &other) const {
+            return priority < other.priority ||
+                   (priority == other.priority && sequenceNumber > other.sequenceNumber);
         }
-        cv.notify_one();
-    }
+    };
 
-    std::vector<TextureLoadResult> retrieveLoadedResources() {
-        bool resultsAvailable = true;
-        std::vector<TextureLoadResult> results;
+    // How long a worker waits before retrying to return a result when the requester
+    // has not picked up the previous ones
+    static constexpr std::chrono::milliseconds fullResultsTimeout{2};
 
-        while (resultsAvailable) {
-            // Check if results are available
-            {
-                std::lock_guard<std::mutex> resultLock(resultsMutex);
-                resultsAvailable = !resultsQueue.empty();
-            }
+    unsigned int maxRequestAge;
+    unsigned long currentFrame = 0;
+    unsigned long nextSequenceNumber = 0;
+    // Requests not yet handed to the workers, by their path
+    std::unordered_map<std::string, PendingRequest> requests;
+    // A heap of the pending requests by their urgency, including outdated entries
+    std::vector<QueuedRequest> queue;
+    // Kept short, so that the order of the requests follows their current priorities
+    BoundedRing<TextureLoadRequest> dispatchedRequests;
+    BoundedRing<TextureLoadResult> results;
+    // Guards the sleep of idle workers. Taken when notifying, so that no wakeup is lost.
+    std::mutex idleMutex;
+    std::condition_variable requestAvailable;
+    std::atomic<bool> isStopping{false};
+    std::vector<std::thread> workers;
 
-            if (resultsAvailable) {
-                // If results are available, process them
-                TextureLoadResult result;
-                {
-                    std::lock_guard<std::mutex> resultLock(resultsMutex);
-                    result = resultsQueue.front();
-                    resultsQueue.pop_front();
+    void workerLoop();
 
-                }
-                results.push_back(result);
-            }
-        }
-        return results;
+    /**
+     * Adds an entry for the request to the heap, and rebuilds the heap once
+     * most of its entries are outdated.
+     */
+    void enqueue(const PendingRequest &pending);
+
+    /**
+     * Moves the most urgent pending requests into the ring read by the workers,
+     * until it is full, and wakes the idle workers.
+     */
+    void dispatchRequests();
+
+public:
+    /**
+     * @param numWorkers The number of threads decoding the textures.
+     * @param maxRequestAge The number of frames a request is kept without being re-asserted.
+     */
+    explicit ResourceFetcher(unsigned int numWorkers = getDefaultNumWorkers(), unsigned int maxRequestAge = 30);
+
+    ~ResourceFetcher();
+
+    ResourceFetcher(const ResourceFetcher &) = delete;
+
+    ResourceFetcher &operator=(const ResourceFetcher &) = delete;
+
+    /**
+     * Registers a request, or re-asserts it if it is still pending. The request is
+     * handed to the workers as soon as they have room for it.
+     */
+    void request(const TextureLoadRequest &job);
+
+    /**
+     * Re-asserts a request that has not been handed to the workers yet and updates its priority.
+     * @return False if the request is no longer pending, i.e., it is being or has been decoded.
+     */
+    bool updatePriority(const std::string &path, float priority);
+
+    /**
+     * Starts a new frame, cancels the requests that have not been re-asserted
+     * during the last maxRequestAge frames, and hands the most urgent ones to the workers.
+     * @return The paths of the cancelled requests.
+     */
+    std::vector<std::string> advanceFrame();
+
+    [[nodiscard]] unsigned int getNumPendingRequests() const {
+        return static_cast<unsigned int>(requests.size());
     }
+
+    /**
+     * Takes all results the workers have finished since the last call. Does not wait.
+     */
+    std::vector<TextureLoadResult> retrieveLoadedResources();
+
+    /**
+     * Drops the requests that have not been started and joins the workers.
+     * Called by the destructor; further requests are ignored.
+     */
+    void stop();
+
+    [[nodiscard]] unsigned int getNumWorkers() const {
+        return static_cast<unsigned int>(workers.size());
+    }
+
+    /**
+     * One worker per hardware thread, except the one running the render loop.
+     */
+    static unsigned int getDefaultNumWorkers();
 };
 
 
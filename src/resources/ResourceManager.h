@@ -8,21 +8,99 @@
 
 #include <memory>
 #include <list>
+#include <deque>
+#include <unordered_map>
 #include <algorithm>
 #include "../textures/Texture.h"
+#include "../textures/TextureArrayPool.h"
+#include "../textures/PixelUploadRing.h"
 
 class ResourceManager {
 private:
-    int maxTextures;
+    /**
+     * An asynchronous upload of a texture from the staging ring.
+     */
+    struct PendingUpload {
+        std::shared_ptr<Texture> texture;
+        PixelUploadRegion region;
+        GLsync fence;
+    };
+
+    // The number of layers texture arrays are allocated with. Large enough that a level is
+    // drawn in a few batches, small enough that a kind of texture rarely used wastes little.
+    static const int layersPerArray = 64;
+
+    // Textures are evicted once the texture arrays holding them would exceed the limit.
+    // The size rather than the count is limited, so that many more compressed tiles fit.
+    size_t maxResidentBytes;
+    size_t residentBytes = 0;
     int loadedTextures = 0;
+    // Changes whenever a texture is loaded into or released from the OpenGL context.
+    unsigned long residencyVersion = 0;
     std::list<std::shared_ptr<Texture>> replacementQueue;
+    // The position of each resident texture in the replacement queue
+    std::unordered_map<const Texture *, std::list<std::shared_ptr<Texture>>::iterator> queuePositions;
+    // Layers of texture arrays holding the loaded textures
+    TextureArrayPool texturePool;
+    // Staging memory the loader copies the decoded pixels into. Shared with
+    // the loader thread, which may finish decoding after the manager is gone.
+    std::shared_ptr<PixelUploadRing> stagingRing;
+    // Uploads in the order they were issued; their fences signal in the same order
+    std::deque<PendingUpload> pendingUploads;
+
+    /**
+     * Reserves a layer of a texture array for the texture. If another array is needed, but
+     * would not fit into the limit, empty arrays are deleted and the least recently used
+     * textures removed until it does. Textures still being uploaded count as resident.
+     * @return An invalid slot if the driver is out of memory even with no textures resident.
+     */
+    TextureArraySlot allocateSlot(const Texture &texture) {
+        Resolution resolution = texture.getResolution();
+        int width = resolution.getWidth();
+        int height = resolution.getHeight();
+        GLenum storageFormat = texture.getStorageFormat();
+        int numLevels = texture.getNumMipLevels();
+        size_t layerSize = texture.getResidentSize();
+        // The limit holds at least a single layer
+        int numLayers = static_cast<int>(std::max<size_t>(
+                std::min<size_t>(layersPerArray, maxResidentBytes / std::max<size_t>(layerSize, 1)), 1));
+
+        while (!texturePool.hasFreeLayer(width, height, storageFormat, numLevels) &&
+               texturePool.getAllocatedBytes() + layerSize * numLayers > maxResidentBytes) {
+            if (!texturePool.releaseEmptyArray()) {
+                if (replacementQueue.empty()) {
+                    break;
+                }
+                popTexture();
+            }
+        }
+
+        TextureArraySlot slot = texturePool.allocate(width, height, storageFormat, numLevels, layerSize, numLayers);
+        // The driver may run out of memory before the limit is reached
+        while (!slot.isValid()) {
+            if (texturePool.releaseEmptyArray()) {
+                // Retry with the memory of the deleted array
+            } else if (numLayers > 1) {
+                numLayers /= 2;
+            } else if (!replacementQueue.empty()) {
+                popTexture();
+            } else {
+                return slot;
+            }
+            slot = texturePool.allocate(width, height, storageFormat, numLevels, layerSize, numLayers);
+        }
+        residentBytes += layerSize;
+        return slot;
+    }
 
     /**
-     * Decides whether a texture should be removed before a new one
-     * is added.
+     * Makes the texture resident and puts it to the front of the replacement queue.
      */
-    [[nodiscard]] bool shouldReplaceTexture() const {
-        return loadedTextures >= maxTextures;
+    void markResident(const std::shared_ptr<Texture> &texture) {
+        loadedTextures++;
+        residencyVersion++;
+        replacementQueue.push_front(texture);
+        queuePositions[texture.get()] = replacementQueue.begin();
     }
 
     /**
@@ -32,13 +110,28 @@ private:
         if (!replacementQueue.empty()) {
             // Use LRU to remove the least recently used texture from the replacement queue.
             std::shared_ptr<Texture> textureToRemove = replacementQueue.back();
+            texturePool.free(textureToRemove->getTextureArraySlot());
+            residentBytes -= textureToRemove->getResidentSize();
             textureToRemove->unloadFromGL();
+            queuePositions.erase(textureToRemove.get());
             replacementQueue.pop_back();
             loadedTextures--;
+            residencyVersion++;
         }
     }
 public:
-    explicit ResourceManager(int maxTextures) : maxTextures(maxTextures) {
+    /**
+     * @param maxResidentBytes The video memory the textures may take up.
+     */
+    explicit ResourceManager(size_t maxResidentBytes, size_t stagingBufferSize = 64 * 1024 * 1024)
+            : maxResidentBytes(maxResidentBytes), stagingRing(std::make_shared<PixelUploadRing>(stagingBufferSize)) {
+    }
+
+    /**
+     * Creates the staging buffer. Must be called from the thread owning the OpenGL context.
+     */
+    void initialize() {
+        stagingRing->initialize();
     }
 
     /**
@@ -47,43 +140,117 @@ public:
      * @param texture
      */
     void addTextureIntoContext(const std::shared_ptr<Texture> &texture) {
-        if (shouldReplaceTexture()) {
-            popTexture();
+        TextureArraySlot slot = allocateSlot(*texture);
+        if (!slot.isValid()) {
+            // The texture is requested again once there is memory for it
+            texture->freeData();
+            return;
         }
-        texture->loadIntoGL();
-        loadedTextures++;
-        replacementQueue.push_front(texture);
+        texture->loadIntoGL(slot);
+        markResident(texture);
+    }
+
+    /**
+     * Starts uploading the texture from its region of the staging ring.
+     * The texture becomes resident once the upload completes, see completeUploads.
+     */
+    void addTextureIntoContext(const std::shared_ptr<Texture> &texture, const PixelUploadRegion &region) {
+        TextureArraySlot slot = allocateSlot(*texture);
+        if (!slot.isValid()) {
+            stagingRing->release(region);
+            return;
+        }
+        texture->beginUpload(slot, stagingRing->getBufferId(), region);
+        GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        pendingUploads.push_back({texture, region, fence});
+    }
+
+    /**
+     * Makes the textures whose uploads have completed resident and recycles their
+     * staging regions. Does not wait for the GPU.
+     */
+    void completeUploads() {
+        while (!pendingUploads.empty()) {
+            PendingUpload &upload = pendingUploads.front();
+            GLenum status = glClientWaitSync(upload.fence, 0, 0);
+            if (status == GL_TIMEOUT_EXPIRED) {
+                break;
+            }
+            if (status == GL_WAIT_FAILED) {
+                std::cerr << "Failed to wait for a texture upload: " << glGetError() << std::endl;
+            }
+            glDeleteSync(upload.fence);
+            stagingRing->release(upload.region);
+            upload.texture->finishUpload();
+            markResident(upload.texture);
+            pendingUploads.pop_front();
+        }
+    }
+
+    /**
+     * Returns a staging region whose texture is no longer needed.
+     */
+    void discardStagedPixels(const PixelUploadRegion &region) {
+        stagingRing->release(region);
+    }
+
+    [[nodiscard]] const std::shared_ptr<PixelUploadRing> &getStagingRing() const {
+        return stagingRing;
     }
 
     /**
      * Moves the texture in the replacement queue to the beginning.
      */
     void noteUsage(const std::shared_ptr<Texture> &texture) {
-        // Search for the texture in the replacement queue
-        auto it = std::find(replacementQueue.begin(), replacementQueue.end(), texture);
-
-        if (it != replacementQueue.end()) {
-            // If found, move it to the beginning of the queue (most recently used).
-            replacementQueue.splice(replacementQueue.begin(), replacementQueue, it);
+        auto it = queuePositions.find(texture.get());
+        if (it != queuePositions.end()) {
+            // If resident, move it to the beginning of the queue (most recently used).
+            // Splicing keeps the stored iterators valid.
+            replacementQueue.splice(replacementQueue.begin(), replacementQueue, it->second);
         }
     }
 
     /**
-     * Releases all loaded textures from the OpenGL context.
+     * Releases all loaded textures and their texture arrays from the OpenGL context.
      */
     void releaseAll() {
         for (const auto &texture : replacementQueue) {
             texture->unloadFromGL();
         }
+        for (const PendingUpload &upload: pendingUploads) {
+            glDeleteSync(upload.fence);
+            upload.texture->unloadFromGL();
+        }
+        pendingUploads.clear();
+        texturePool.releaseAll();
+        stagingRing->destroy();
 
         replacementQueue.clear();
+        queuePositions.clear();
         loadedTextures = 0;
+        residentBytes = 0;
+        residencyVersion++;
     }
 
     [[nodiscard]] unsigned int getNumLoadedTextures() const {
         return loadedTextures;
     }
 
+    /**
+     * The video memory taken up by the loaded textures and those being uploaded.
+     */
+    [[nodiscard]] size_t getResidentBytes() const {
+        return residentBytes;
+    }
+
+    [[nodiscard]] unsigned int getNumTextureArrays() const {
+        return texturePool.getNumTextureArrays();
+    }
+
+    [[nodiscard]] unsigned long getResidencyVersion() const {
+        return residencyVersion;
+    }
+
 };
 
 
@@ -1,2 +1,9 @@
+#include "textures/PixelBufferPool.h"
+
+// Decoded tiles reuse the buffers of the tiles uploaded before them
+#define STBI_MALLOC(size) PixelBufferPool::getInstance().allocate(size)
+#define STBI_REALLOC(pointer, newSize) PixelBufferPool::getInstance().reallocate(pointer, newSize)
+#define STBI_FREE(pointer) PixelBufferPool::getInstance().release(pointer)
+
 #define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
\ No newline at end of file
+#include "stb_image.h"
@@ -9,6 +9,8 @@
 #include "../textures/Texture.h"
 #include "../ellipsoid.h"
 #include "../tiling/Tile.h"
+#include "../vertex.h"
+#include "VertexCacheOptimizer.h"
 
 class TileMeshTesselator {
 private:
@@ -39,43 +41,44 @@ private:
         return geodeticCoordinates;
     }
 public:
+    // Size of the simulated post-transform vertex cache used to order the triangles
+    static const unsigned int vertexCacheSize = 16;
+
     /**
      * Generate a uniform triangle mesh for a given tile with the specified resolution.
      *
      * This function creates a mesh of triangles to cover a tile's geographical region on the ellipsoid's surface.
+     * Each vertex of the grid is stored once. The triangles are ordered for the reuse of transformed
+     * vertices by the GPU.
      *
      * @param meshResolution The resolution (width and height) of the generated uniform mesh.
-     * @param ellipsoid The ellipsoid onto which the mesh is projected.
      * @param tile The specific part of the ellipsoid that the mesh represents.
-     * @return A vector of 3D vertices forming triangles. Each group of three vertices defines a single triangle.
+     * @return The vertices of the grid and the indices of its triangles.
      */
-    std::vector<glm::vec3> generate(Resolution &meshResolution, Tile &tile) {
-
-        std::vector<glm::vec3> meshVertices;
-
-        // You should generate mesh vertices and populate the meshVertices vector.
+    IndexedMesh generate(Resolution &meshResolution, Tile &tile) {
+        IndexedMesh mesh;
+        int numColumns = meshResolution.getWidth() + 1;
+        for (int y = 0; y <= meshResolution.getHeight(); y++) {
+            for (int x = 0; x <= meshResolution.getWidth(); x++) {
+                mesh.vertices.push_back(calculateVertexPosition(x, y, meshResolution, tile));
+            }
+        }
 
-        // Example: Generate a simple quad mesh (adjust for your actual mesh generation):
         for (int y = 0; y < meshResolution.getHeight(); y++) {
             for (int x = 0; x < meshResolution.getWidth(); x++) {
-                // Calculate vertex positions based on resolution, ellipsoid, and tile information.
-                glm::vec3 vertex1 = calculateVertexPosition(x, y, meshResolution, tile);
-                glm::vec3 vertex2 = calculateVertexPosition(x + 1, y, meshResolution, tile);
-                glm::vec3 vertex3 = calculateVertexPosition(x, y + 1, meshResolution, tile);
-                glm::vec3 vertex4 = calculateVertexPosition(x + 1, y + 1, meshResolution, tile);
-
-                // Add vertices to the meshVertices vector, forming triangles.
-                meshVertices.push_back(vertex1);
-                meshVertices.push_back(vertex2);
-                meshVertices.push_back(vertex3);
+                unsigned int vertex1 = y * numColumns + x;
+                unsigned int vertex2 = vertex1 + 1;
+                unsigned int vertex3 = vertex1 + numColumns;
+                unsigned int vertex4 = vertex3 + 1;
 
-                meshVertices.push_back(vertex2);
-                meshVertices.push_back(vertex4);
-                meshVertices.push_back(vertex3);
+                // Each quad is made up of two triangles.
+                mesh.indices.insert(mesh.indices.end(), {vertex1, vertex2, vertex3});
+                mesh.indices.insert(mesh.indices.end(), {vertex2, vertex4, vertex3});
             }
         }
 
-        return meshVertices;
+        VertexCacheOptimizer::optimize(mesh, vertexCacheSize);
+        return mesh;
     }
 };
 
@@ -0,0 +1,148 @@
+#include "VertexCacheOptimizer.h"
+#include <cassert>
+
+void VertexCacheOptimizer::optimize(IndexedMesh &mesh, unsigned int cacheSize) {
+    mesh.indices = reorderTriangles(mesh.indices, mesh.vertices.size(), cacheSize);
+    reorderVertices(mesh);
+}
+
+std::vector<unsigned int> VertexCacheOptimizer::reorderTriangles(const std::vector<unsigned int> &indices,
+                                                                 unsigned int numVertices,
+                                                                 unsigned int cacheSize) {
+    assert(indices.size() % 3 == 0);
+    auto numTriangles = static_cast<unsigned int>(indices.size() / 3);
+    std::vector<unsigned int> reordered;
+    reordered.reserve(indices.size());
+    if (numTriangles == 0 || numVertices == 0) {
+        return reordered;
+    }
+
+    // Triangles adjacent to each vertex stored as offsets into a single array
+    std::vector<unsigned int> adjacencyOffsets(numVertices + 1, 0);
+    for (unsigned int index: indices) {
+        adjacencyOffsets[index + 1]++;
+    }
+    for (unsigned int vertex = 0; vertex < numVertices; vertex++) {
+        adjacencyOffsets[vertex + 1] += adjacencyOffsets[vertex];
+    }
+    std::vector<unsigned int> adjacentTriangles(indices.size());
+    std::vector<unsigned int> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (unsigned int i = 0; i < indices.size(); i++) {
+        adjacentTriangles[fillOffsets[indices[i]]++] = i / 3;
+    }
+
+    // The number of adjacent triangles not emitted yet
+    std::vector<unsigned int> liveTriangles(numVertices);
+    for (unsigned int vertex = 0; vertex < numVertices; vertex++) {
+        liveTriangles[vertex] = adjacencyOffsets[vertex + 1] - adjacencyOffsets[vertex];
+    }
+    // The time at which each vertex entered the cache
+    std::vector<unsigned int> cacheTimeStamps(numVertices, 0);
+    std::vector<bool> isEmitted(numTriangles, false);
+    std::vector<unsigned int> deadEndStack;
+    std::vector<unsigned int> candidates;
+
+    unsigned int time = cacheSize + 1;
+    unsigned int cursor = 0;
+    long fanningVertex = 0;
+
+    // Returns a vertex with remaining triangles, first from the recently used ones,
+    // then in the input order
+    auto skipDeadEnd = [&]() -> long {
+        while (!deadEndStack.empty()) {
+            unsigned int vertex = deadEndStack.back();
+            deadEndStack.pop_back();
+            if (liveTriangles[vertex] > 0) {
+                return vertex;
+            }
+        }
+        while (cursor < numVertices) {
+            if (liveTriangles[cursor] > 0) {
+                return cursor;
+            }
+            cursor++;
+        }
+        return -1;
+    };
+
+    while (fanningVertex >= 0) {
+        candidates.clear();
+        auto vertex = static_cast<unsigned int>(fanningVertex);
+        for (unsigned int a = adjacencyOffsets[vertex]; a < adjacencyOffsets[vertex + 1]; a++) {
+            unsigned int triangle = adjacentTriangles[a];
+            if (isEmitted[triangle]) {
+                continue;
+            }
+            for (unsigned int corner = 0; corner < 3; corner++) {
+                unsigned int triangleVertex = indices[triangle * 3 + corner];
+                reordered.push_back(triangleVertex);
+                deadEndStack.push_back(triangleVertex);
+                candidates.push_back(triangleVertex);
+                liveTriangles[triangleVertex]--;
+                if (time - cacheTimeStamps[triangleVertex] > cacheSize) {
+                    cacheTimeStamps[triangleVertex] = time;
+                    time++;
+                }
+            }
+            isEmitted[triangle] = true;
+        }
+
+        // Continue with the candidate which stays in the cache the longest
+        // once all its remaining triangles are emitted
+        long nextVertex = -1;
+        long bestPriority = -1;
+        for (unsigned int candidate: candidates) {
+            if (liveTriangles[candidate] == 0) {
+                continue;
+            }
+            long priority = 0;
+            long age = static_cast<long>(time - cacheTimeStamps[candidate]);
+            if (age + 2 * static_cast<long>(liveTriangles[candidate]) <= static_cast<long>(cacheSize)) {
+                priority = age;
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                nextVertex = candidate;
+            }
+        }
+        fanningVertex = nextVertex >= 0 ? nextVertex : skipDeadEnd();
+    }
+
+    assert(reordered.size() == indices.size());
+    return reordered;
+}
+
+void VertexCacheOptimizer::reorderVertices(IndexedMesh &mesh) {
+    const unsigned int unassigned = ~0u;
+    std::vector<unsigned int> newIndices(mesh.vertices.size(), unassigned);
+    Mesh_t reorderedVertices;
+    reorderedVertices.reserve(mesh.vertices.size());
+
+    for (unsigned int &index: mesh.indices) {
+        if (newIndices[index] == unassigned) {
+            newIndices[index] = static_cast<unsigned int>(reorderedVertices.size());
+            reorderedVertices.push_back(mesh.vertices[index]);
+        }
+        index = newIndices[index];
+    }
+    // Unreferenced vertices are dropped
+    mesh.vertices = std::move(reorderedVertices);
+}
+
+double VertexCacheOptimizer::computeAverageCacheMissRatio(const std::vector<unsigned int> &indices,
+                                                          unsigned int numVertices, unsigned int cacheSize) {
+    if (indices.empty()) {
+        return 0;
+    }
+    // A vertex is in the FIFO cache if it entered it less than cacheSize misses ago
+    std::vector<long> entryTimes(numVertices, -1);
+    long misses = 0;
+    for (unsigned int index: indices) {
+        bool isCached = entryTimes[index] >= 0 && misses - entryTimes[index] < static_cast<long>(cacheSize);
+        if (!isCached) {
+            entryTimes[index] = misses;
+            misses++;
+        }
+    }
+    return static_cast<double>(misses) / static_cast<double>(indices.size() / 3);
+}
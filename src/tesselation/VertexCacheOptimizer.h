@@ -0,0 +1,45 @@
+#ifndef EARTH_VISUALIZATION_VERTEXCACHEOPTIMIZER_H
+#define EARTH_VISUALIZATION_VERTEXCACHEOPTIMIZER_H
+
+#include <vector>
+#include "../vertex.h"
+
+/**
+ * Reorders triangles of indexed meshes so that the GPU reuses transformed vertices
+ * from its post-transform cache as often as possible.
+ *
+ * The triangle order is computed with Tipsify from Sander, Nehab, and Barczak:
+ * "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw" (2007).
+ */
+class VertexCacheOptimizer {
+public:
+    /**
+     * Reorders the triangles for a cache of the given size and then the vertices
+     * in the order of their first use, which also improves the locality of vertex fetches.
+     * The winding of the triangles is preserved.
+     */
+    static void optimize(IndexedMesh &mesh, unsigned int cacheSize);
+
+    /**
+     * Computes the triangle order of the Tipsify algorithm.
+     *
+     * @return The indices of the reordered triangles.
+     */
+    static std::vector<unsigned int> reorderTriangles(const std::vector<unsigned int> &indices,
+                                                      unsigned int numVertices, unsigned int cacheSize);
+
+    /**
+     * Renumbers the vertices in the order in which the indices reference them.
+     */
+    static void reorderVertices(IndexedMesh &mesh);
+
+    /**
+     * Simulates a FIFO cache of the given size and returns the average number
+     * of vertices transformed per triangle (ACMR). It lies between 0.5 for an ideal
+     * order of a large grid and 3 if no vertex is ever reused.
+     */
+    static double computeAverageCacheMissRatio(const std::vector<unsigned int> &indices,
+                                               unsigned int numVertices, unsigned int cacheSize);
+};
+
+#endif //EARTH_VISUALIZATION_VERTEXCACHEOPTIMIZER_H
@@ -0,0 +1,350 @@
+#include "BlockCompression.h"
+#include "MipChain.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+// The pixels of a block, row by row
+static const int pixelsPerBlock = BlockCompression::blockWidth * BlockCompression::blockWidth;
+
+// Interpolation weights of BC7 blocks with 4-bit indices, out of 64
+static const int bc7Weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+/**
+ * Writes values into a block, starting at its least significant bit.
+ */
+class BitWriter {
+private:
+    unsigned char *bytes;
+    int position = 0;
+
+public:
+    explicit BitWriter(unsigned char *bytes) : bytes(bytes) {
+    }
+
+    void write(uint32_t value, int numBits) {
+        for (int bit = 0; bit < numBits; bit++, position++) {
+            if ((value >> bit) & 1) {
+                bytes[position / 8] |= static_cast<unsigned char>(1 << (position % 8));
+            }
+        }
+    }
+};
+
+/**
+ * Fits a line through the colors of a block along their principal axis.
+ * The endpoints are the projections of the extreme colors onto the line.
+ */
+static void fitColorLine(const float colors[][3], float start[3], float end[3]) {
+    float mean[3] = {0, 0, 0};
+    for (int i = 0; i < pixelsPerBlock; i++) {
+        for (int c = 0; c < 3; c++) {
+            mean[c] += colors[i][c] / pixelsPerBlock;
+        }
+    }
+
+    float covariance[3][3] = {};
+    for (int i = 0; i < pixelsPerBlock; i++) {
+        float delta[3] = {colors[i][0] - mean[0], colors[i][1] - mean[1], colors[i][2] - mean[2]};
+        for (int row = 0; row < 3; row++) {
+            for (int column = 0; column < 3; column++) {
+                covariance[row][column] += delta[row] * delta[column];
+            }
+        }
+    }
+
+    // Power iteration converges to the eigenvector of the largest eigenvalue
+    float axis[3] = {1, 1, 1};
+    for (int iteration = 0; iteration < 8; iteration++) {
+        float next[3];
+        for (int row = 0; row < 3; row++) {
+            next[row] = covariance[row][0] * axis[0] + covariance[row][1] * axis[1] + covariance[row][2] * axis[2];
+        }
+        float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+        if (length < 1e-6f) {
+            // All colors are the same
+            std::copy(mean, mean + 3, start);
+            std::copy(mean, mean + 3, end);
+            return;
+        }
+        for (int c = 0; c < 3; c++) {
+            axis[c] = next[c] / length;
+        }
+    }
+
+    float minProjection = 0, maxProjection = 0;
+    for (int i = 0; i < pixelsPerBlock; i++) {
+        float projection = (colors[i][0] - mean[0]) * axis[0] + (colors[i][1] - mean[1]) * axis[1] +
+                           (colors[i][2] - mean[2]) * axis[2];
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+    for (int c = 0; c < 3; c++) {
+        start[c] = mean[c] + minProjection * axis[c];
+        end[c] = mean[c] + maxProjection * axis[c];
+    }
+}
+
+static int quantize(float value, int maxValue) {
+    return std::clamp(static_cast<int>(std::lround(value * maxValue / 255.0f)), 0, maxValue);
+}
+
+static float getSquaredDistance(const int first[3], const float second[3]) {
+    float distance = 0;
+    for (int c = 0; c < 3; c++) {
+        float delta = static_cast<float>(first[c]) - second[c];
+        distance += delta * delta;
+    }
+    return distance;
+}
+
+/**
+ * Picks the palette entry closest to each color.
+ */
+static void findClosestIndices(const float colors[][3], const int palette[][3], int paletteSize, int indices[]) {
+    for (int i = 0; i < pixelsPerBlock; i++) {
+        float bestDistance = getSquaredDistance(palette[0], colors[i]);
+        indices[i] = 0;
+        for (int entry = 1; entry < paletteSize; entry++) {
+            float distance = getSquaredDistance(palette[entry], colors[i]);
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                indices[i] = entry;
+            }
+        }
+    }
+}
+
+static uint16_t packRgb565(const float color[3]) {
+    return static_cast<uint16_t>((quantize(color[0], 31) << 11) | (quantize(color[1], 63) << 5) |
+                                 quantize(color[2], 31));
+}
+
+static void unpackRgb565(uint16_t packed, int color[3]) {
+    int red = (packed >> 11) & 31;
+    int green = (packed >> 5) & 63;
+    int blue = packed & 31;
+    color[0] = (red << 3) | (red >> 2);
+    color[1] = (green << 2) | (green >> 4);
+    color[2] = (blue << 3) | (blue >> 2);
+}
+
+/**
+ * Two RGB565 endpoints and 2-bit indices. The first endpoint is kept greater than
+ * the second one, which selects the mode with two interpolated colors.
+ */
+static void encodeBC1Block(const float colors[][3], unsigned char *block) {
+    float start[3], end[3];
+    fitColorLine(colors, start, end);
+    uint16_t color0 = packRgb565(end);
+    uint16_t color1 = packRgb565(start);
+    if (color0 < color1) {
+        std::swap(color0, color1);
+    }
+
+    uint32_t packedIndices = 0;
+    if (color0 != color1) {
+        int palette[4][3];
+        unpackRgb565(color0, palette[0]);
+        unpackRgb565(color1, palette[1]);
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        int indices[pixelsPerBlock];
+        findClosestIndices(colors, palette, 4, indices);
+        for (int i = 0; i < pixelsPerBlock; i++) {
+            packedIndices |= static_cast<uint32_t>(indices[i]) << (2 * i);
+        }
+    }
+
+    BitWriter writer(block);
+    writer.write(color0, 16);
+    writer.write(color1, 16);
+    writer.write(packedIndices, 32);
+}
+
+/**
+ * Two 8-bit endpoints and 3-bit indices. The first endpoint is kept greater than
+ * the second one, which selects the mode with six interpolated values.
+ */
+static void encodeBC4Block(const unsigned char values[], unsigned char *block) {
+    int red0 = *std::max_element(values, values + pixelsPerBlock);
+    int red1 = *std::min_element(values, values + pixelsPerBlock);
+
+    int palette[8] = {red0, red1};
+    for (int i = 2; i < 8; i++) {
+        palette[i] = ((8 - i) * red0 + (i - 1) * red1 + 3) / 7;
+    }
+
+    BitWriter writer(block);
+    writer.write(red0, 8);
+    writer.write(red1, 8);
+    for (int i = 0; i < pixelsPerBlock; i++) {
+        int bestIndex = 0;
+        if (red0 != red1) {
+            for (int entry = 1; entry < 8; entry++) {
+                if (std::abs(palette[entry] - values[i]) < std::abs(palette[bestIndex] - values[i])) {
+                    bestIndex = entry;
+                }
+            }
+        }
+        writer.write(bestIndex, 3);
+    }
+}
+
+/**
+ * Mode 6: a single subset with RGBA 7-bit endpoints, a p-bit per endpoint and 4-bit indices.
+ * The alpha is opaque, which sets both p-bits, so the colors of the endpoints are odd.
+ */
+static void encodeBC7Block(const float colors[][3], unsigned char *block) {
+    float start[3], end[3];
+    fitColorLine(colors, start, end);
+
+    int endpoints[2][3];
+    for (int c = 0; c < 3; c++) {
+        endpoints[0][c] = std::clamp(static_cast<int>(std::lround((start[c] - 1) / 2)), 0, 127);
+        endpoints[1][c] = std::clamp(static_cast<int>(std::lround((end[c] - 1) / 2)), 0, 127);
+    }
+
+    int palette[16][3];
+    for (int entry = 0; entry < 16; entry++) {
+        for (int c = 0; c < 3; c++) {
+            int value0 = (endpoints[0][c] << 1) | 1;
+            int value1 = (endpoints[1][c] << 1) | 1;
+            palette[entry][c] = ((64 - bc7Weights[entry]) * value0 + bc7Weights[entry] * value1 + 32) >> 6;
+        }
+    }
+    int indices[pixelsPerBlock];
+    findClosestIndices(colors, palette, 16, indices);
+
+    // The most significant bit of the first index is implied to be zero
+    if (indices[0] >= 8) {
+        std::swap(endpoints[0], endpoints[1]);
+        for (int &index: indices) {
+            index = 15 - index;
+        }
+    }
+
+    BitWriter writer(block);
+    writer.write(1 << 6, 7);
+    for (int c = 0; c < 3; c++) {
+        writer.write(endpoints[0][c], 7);
+        writer.write(endpoints[1][c], 7);
+    }
+    writer.write(127, 7);
+    writer.write(127, 7);
+    writer.write(1, 1);
+    writer.write(1, 1);
+    writer.write(indices[0], 3);
+    for (int i = 1; i < pixelsPerBlock; i++) {
+        writer.write(indices[i], 4);
+    }
+}
+
+size_t BlockCompression::getBlockSize(TextureCompression compression) {
+    switch (compression) {
+        case TextureCompression::BC1:
+        case TextureCompression::BC4:
+            return 8;
+        case TextureCompression::BC7:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+bool BlockCompression::isCompatible(TextureCompression compression, int channels) {
+    switch (compression) {
+        case TextureCompression::BC1:
+        case TextureCompression::BC7:
+            return channels >= 3;
+        case TextureCompression::BC4:
+            return channels == 1;
+        default:
+            return true;
+    }
+}
+
+size_t BlockCompression::getLevelSize(TextureCompression compression, int width, int height, int channels,
+                                      int level) {
+    if (compression == TextureCompression::None) {
+        return MipChain::getLevelSize(width, height, channels, level);
+    }
+    size_t blocksPerRow = (MipChain::getLevelExtent(width, level) + blockWidth - 1) / blockWidth;
+    size_t blocksPerColumn = (MipChain::getLevelExtent(height, level) + blockWidth - 1) / blockWidth;
+    return blocksPerRow * blocksPerColumn * getBlockSize(compression);
+}
+
+size_t BlockCompression::getLevelOffset(TextureCompression compression, int width, int height, int channels,
+                                        int level) {
+    return getChainSize(compression, width, height, channels, level);
+}
+
+size_t BlockCompression::getChainSize(TextureCompression compression, int width, int height, int channels,
+                                      int numLevels) {
+    size_t size = 0;
+    for (int level = 0; level < numLevels; level++) {
+        size += getLevelSize(compression, width, height, channels, level);
+    }
+    return size;
+}
+
+void BlockCompression::encode(TextureCompression compression, const unsigned char *pixels, int width, int height,
+                              int channels, unsigned char *blocks) {
+    assert(compression != TextureCompression::None);
+    assert(isCompatible(compression, channels));
+    size_t blockSize = getBlockSize(compression);
+    int blocksPerRow = (width + blockWidth - 1) / blockWidth;
+    int blocksPerColumn = (height + blockWidth - 1) / blockWidth;
+
+    float colors[pixelsPerBlock][3];
+    unsigned char values[pixelsPerBlock];
+    for (int blockY = 0; blockY < blocksPerColumn; blockY++) {
+        for (int blockX = 0; blockX < blocksPerRow; blockX++) {
+            for (int i = 0; i < pixelsPerBlock; i++) {
+                int x = std::min(blockX * blockWidth + i % blockWidth, width - 1);
+                int y = std::min(blockY * blockWidth + i / blockWidth, height - 1);
+                const unsigned char *pixel = pixels + (static_cast<size_t>(y) * width + x) * channels;
+                values[i] = pixel[0];
+                if (channels >= 3) {
+                    colors[i][0] = pixel[0];
+                    colors[i][1] = pixel[1];
+                    colors[i][2] = pixel[2];
+                }
+            }
+
+            unsigned char *block = blocks + (static_cast<size_t>(blockY) * blocksPerRow + blockX) * blockSize;
+            std::memset(block, 0, blockSize);
+            switch (compression) {
+                case TextureCompression::BC1:
+                    encodeBC1Block(colors, block);
+                    break;
+                case TextureCompression::BC4:
+                    encodeBC4Block(values, block);
+                    break;
+                case TextureCompression::BC7:
+                    encodeBC7Block(colors, block);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+bool BlockCompression::parseCompression(const std::string &name, TextureCompression &compression) {
+    if (name == "none") {
+        compression = TextureCompression::None;
+    } else if (name == "bc1") {
+        compression = TextureCompression::BC1;
+    } else if (name == "bc4") {
+        compression = TextureCompression::BC4;
+    } else if (name == "bc7") {
+        compression = TextureCompression::BC7;
+    } else {
+        return false;
+    }
+    return true;
+}
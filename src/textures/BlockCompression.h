@@ -0,0 +1,77 @@
+#ifndef EARTH_VISUALIZATION_BLOCKCOMPRESSION_H
+#define EARTH_VISUALIZATION_BLOCKCOMPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * The GPU block-compressed formats textures can be stored in. Each format encodes
+ * blocks of 4x4 pixels into a fixed number of bytes, which the GPU samples directly.
+ */
+enum class TextureCompression : uint32_t {
+    None = 0,
+    // RGB at 4 bits per pixel; for day and night maps
+    BC1 = 1,
+    // A single channel at 4 bits per pixel; for height maps
+    BC4 = 2,
+    // RGB at 8 bits per pixel with a higher quality than BC1
+    BC7 = 3
+};
+
+/**
+ * Encodes images into block-compressed formats, and describes the layout of
+ * compressed mip chains.
+ *
+ * The encoders favour simplicity over quality: the endpoints of each block are
+ * fitted along the principal axis of its colors. BC7 blocks are always written
+ * in mode 6, which has a single subset and 16 interpolation steps.
+ */
+class BlockCompression {
+public:
+    // Blocks have 4x4 pixels
+    static const int blockWidth = 4;
+
+    /**
+     * The number of bytes of a single block. Zero if not compressed.
+     */
+    static size_t getBlockSize(TextureCompression compression);
+
+    /**
+     * Whether images with the given number of channels can be encoded in the format.
+     */
+    static bool isCompatible(TextureCompression compression, int channels);
+
+    /**
+     * The number of bytes of a level of the mip chain. For compressed formats,
+     * partial blocks at the edges of small levels take a whole block.
+     */
+    static size_t getLevelSize(TextureCompression compression, int width, int height, int channels, int level);
+
+    /**
+     * The offset of the level from the beginning of the mip chain.
+     */
+    static size_t getLevelOffset(TextureCompression compression, int width, int height, int channels, int level);
+
+    /**
+     * The number of bytes of the given number of levels.
+     */
+    static size_t getChainSize(TextureCompression compression, int width, int height, int channels, int numLevels);
+
+    /**
+     * Encodes an image with tightly packed rows. Blocks crossing the edges of the
+     * image repeat its edge pixels. Only the first channel is encoded into BC4,
+     * only the first three into BC1 and BC7.
+     * @param blocks Receives the blocks row by row.
+     */
+    static void encode(TextureCompression compression, const unsigned char *pixels, int width, int height,
+                       int channels, unsigned char *blocks);
+
+    /**
+     * Parses the name of a format, e.g., "bc1", as used on the command line of the tools.
+     * @return False if there is no such format.
+     */
+    static bool parseCompression(const std::string &name, TextureCompression &compression);
+};
+
+#endif //EARTH_VISUALIZATION_BLOCKCOMPRESSION_H
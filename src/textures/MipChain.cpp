@@ -0,0 +1,164 @@
+#include "MipChain.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define MIP_CHAIN_SSE
+#endif
+
+int MipChain::getNumLevels(int width, int height) {
+    int numLevels = 1;
+    int size = std::max(width, height);
+    while (size > 1) {
+        size /= 2;
+        numLevels++;
+    }
+    return numLevels;
+}
+
+int MipChain::getLevelExtent(int size, int level) {
+    return std::max(size >> level, 1);
+}
+
+size_t MipChain::getLevelSize(int width, int height, int channels, int level) {
+    return static_cast<size_t>(getLevelExtent(width, level)) * getLevelExtent(height, level) * channels;
+}
+
+size_t MipChain::getLevelOffset(int width, int height, int channels, int level) {
+    return getChainSize(width, height, channels, level);
+}
+
+size_t MipChain::getChainSize(int width, int height, int channels, int numLevels) {
+    size_t size = 0;
+    for (int level = 0; level < numLevels; level++) {
+        size += getLevelSize(width, height, channels, level);
+    }
+    return size;
+}
+
+void MipChain::downsample(const unsigned char *source, int width, int height, int channels,
+                          unsigned char *destination) {
+#if defined(MIP_CHAIN_SSE)
+    downsampleSse(source, width, height, channels, destination);
+#else
+    downsampleScalar(source, width, height, channels, destination);
+#endif
+}
+
+void MipChain::downsampleScalar(const unsigned char *source, int width, int height, int channels,
+                                unsigned char *destination) {
+    int destinationWidth = getLevelExtent(width, 1);
+    int destinationHeight = getLevelExtent(height, 1);
+    size_t sourceStride = static_cast<size_t>(width) * channels;
+
+    for (int y = 0; y < destinationHeight; y++) {
+        const unsigned char *row0 = source + std::min(2 * y, height - 1) * sourceStride;
+        const unsigned char *row1 = source + std::min(2 * y + 1, height - 1) * sourceStride;
+        unsigned char *destinationRow = destination + static_cast<size_t>(y) * destinationWidth * channels;
+        downsampleRow(row0, row1, width, channels, 0, destinationWidth, destinationRow);
+    }
+}
+
+#if defined(MIP_CHAIN_SSE)
+
+void MipChain::downsampleSse(const unsigned char *source, int width, int height, int channels,
+                             unsigned char *destination) {
+    int destinationWidth = getLevelExtent(width, 1);
+    int destinationHeight = getLevelExtent(height, 1);
+    int sourceStride = width * channels;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i two = _mm_set1_epi16(2);
+
+    // Sums of the two source rows. Padded, as the last pixels are read four lanes at a time.
+    std::vector<uint16_t> rowSums(sourceStride + 4);
+
+    for (int y = 0; y < destinationHeight; y++) {
+        const unsigned char *row0 = source + static_cast<size_t>(std::min(2 * y, height - 1)) * sourceStride;
+        const unsigned char *row1 = source + static_cast<size_t>(std::min(2 * y + 1, height - 1)) * sourceStride;
+        unsigned char *destinationRow = destination + static_cast<size_t>(y) * destinationWidth * channels;
+
+        // Vertical pass: widen 16 bytes of each row to 16 bits and add them
+        int i = 0;
+        for (; i + 16 <= sourceStride; i += 16) {
+            __m128i top = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + i));
+            __m128i bottom = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + i));
+            __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+            __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(rowSums.data() + i), low);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(rowSums.data() + i + 8), high);
+        }
+        for (; i < sourceStride; i++) {
+            rowSums[i] = static_cast<uint16_t>(row0[i] + row1[i]);
+        }
+
+        // Horizontal pass: add the sums of neighbouring pixels and divide by four
+        int x = 0;
+        if (channels == 1) {
+            // Eight pixels at a time; pairs of lanes are added by multiplying them by one
+            for (; 2 * x + 16 <= width; x += 8) {
+                __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&rowSums[2 * x]));
+                __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&rowSums[2 * x + 8]));
+                first = _mm_madd_epi16(first, ones);
+                second = _mm_madd_epi16(second, ones);
+                __m128i sums = _mm_srli_epi16(_mm_add_epi16(_mm_packs_epi32(first, second), two), 2);
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(destinationRow + x), _mm_packus_epi16(sums, sums));
+            }
+        } else if (channels <= 4) {
+            // A pixel at a time, all channels at once. Four bytes are stored, so the last
+            // pixel, whose extra bytes would not be overwritten by the next one, is left out.
+            for (; x < destinationWidth - 1; x++) {
+                int right = std::min(2 * x + 1, width - 1);
+                __m128i left = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(&rowSums[2 * x * channels]));
+                __m128i rightSums = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(&rowSums[right * channels]));
+                __m128i sums = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(left, rightSums), two), 2);
+                auto pixel = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_packus_epi16(sums, sums)));
+                std::memcpy(destinationRow + x * channels, &pixel, sizeof(pixel));
+            }
+        }
+        downsampleRow(row0, row1, width, channels, x, destinationWidth, destinationRow);
+    }
+}
+
+#endif
+
+void MipChain::downsampleRow(const unsigned char *row0, const unsigned char *row1, int width, int channels,
+                             int firstX, int lastX, unsigned char *destinationRow) {
+    for (int x = firstX; x < lastX; x++) {
+        size_t left = static_cast<size_t>(std::min(2 * x, width - 1)) * channels;
+        size_t right = static_cast<size_t>(std::min(2 * x + 1, width - 1)) * channels;
+        for (int channel = 0; channel < channels; channel++) {
+            unsigned int sum = row0[left + channel] + row0[right + channel] +
+                               row1[left + channel] + row1[right + channel];
+            // Round to the nearest value
+            destinationRow[x * channels + channel] = static_cast<unsigned char>((sum + 2) / 4);
+        }
+    }
+}
+
+void MipChain::buildLevels(const unsigned char *pixels, int width, int height, int channels, int numLevels,
+                           unsigned char *levels) {
+    const unsigned char *source = pixels;
+    unsigned char *destination = levels;
+    for (int level = 1; level < numLevels; level++) {
+        downsample(source, getLevelExtent(width, level - 1), getLevelExtent(height, level - 1), channels,
+                   destination);
+        source = destination;
+        destination += getLevelSize(width, height, channels, level);
+    }
+}
+
+void MipChain::build(unsigned char *chain, int width, int height, int channels, int numLevels) {
+    buildLevels(chain, width, height, channels, numLevels, chain + getLevelSize(width, height, channels, 0));
+}
+
+const char *MipChain::getInstructionSet() {
+#if defined(MIP_CHAIN_SSE)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,79 @@
+#ifndef EARTH_VISUALIZATION_MIPCHAIN_H
+#define EARTH_VISUALIZATION_MIPCHAIN_H
+
+#include <cstddef>
+
+/**
+ * Mipmap levels of a texture stored one after another, starting with the full
+ * resolution. Each level halves the size of the previous one, rounding down,
+ * down to 1x1 pixels. The rows are tightly packed.
+ */
+class MipChain {
+public:
+    /**
+     * The number of levels of a full chain.
+     */
+    static int getNumLevels(int width, int height);
+
+    /**
+     * The width or the height of the given level; halved at each level, but at least one pixel.
+     */
+    static int getLevelExtent(int size, int level);
+
+    /**
+     * The number of bytes of the given level.
+     */
+    static size_t getLevelSize(int width, int height, int channels, int level);
+
+    /**
+     * The offset of the level from the beginning of the chain.
+     */
+    static size_t getLevelOffset(int width, int height, int channels, int level);
+
+    /**
+     * The number of bytes of the given number of levels.
+     */
+    static size_t getChainSize(int width, int height, int channels, int numLevels);
+
+    /**
+     * Averages each 2x2 block of pixels. Pixels beyond the edge of an odd-sized
+     * source are clamped to the edge. Uses SSE2 if available.
+     */
+    static void downsample(const unsigned char *source, int width, int height, int channels,
+                           unsigned char *destination);
+
+    /**
+     * The reference implementation of downsample; gives the same results.
+     */
+    static void downsampleScalar(const unsigned char *source, int width, int height, int channels,
+                                 unsigned char *destination);
+
+    /**
+     * Computes the levels after the first one from the given pixels.
+     * @param levels Receives the levels one after another, i.e., the chain without its first level.
+     */
+    static void buildLevels(const unsigned char *pixels, int width, int height, int channels, int numLevels,
+                            unsigned char *levels);
+
+    /**
+     * Fills the levels after the first one, which has to be in place already.
+     */
+    static void build(unsigned char *chain, int width, int height, int channels, int numLevels);
+
+    /**
+     * The instruction set downsample was compiled with.
+     */
+    [[nodiscard]] static const char *getInstructionSet();
+
+private:
+    /**
+     * Computes the pixels [firstX, lastX) of a row of the downsampled image from two source rows.
+     */
+    static void downsampleRow(const unsigned char *row0, const unsigned char *row1, int width, int channels,
+                              int firstX, int lastX, unsigned char *destinationRow);
+
+    static void downsampleSse(const unsigned char *source, int width, int height, int channels,
+                              unsigned char *destination);
+};
+
+#endif //EARTH_VISUALIZATION_MIPCHAIN_H
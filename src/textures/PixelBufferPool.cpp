@@ -0,0 +1,106 @@
+#include "PixelBufferPool.h"
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+PixelBufferPool::~PixelBufferPool() {
+    for (auto &sizeClass: idleBlocks) {
+        for (BlockHeader *header: sizeClass.second) {
+            std::free(header);
+        }
+    }
+}
+
+PixelBufferPool &PixelBufferPool::getInstance() {
+    static PixelBufferPool pool;
+    return pool;
+}
+
+void *PixelBufferPool::allocate(size_t size) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = idleBlocks.find(size);
+        if (it != idleBlocks.end()) {
+            if (!it->second.empty()) {
+                BlockHeader *header = it->second.back();
+                it->second.pop_back();
+                statistics.idleBytes -= size;
+                statistics.hits++;
+                return header + 1;
+            }
+            statistics.misses++;
+        }
+    }
+
+    auto *header = static_cast<BlockHeader *>(std::malloc(sizeof(BlockHeader) + size));
+    if (header == nullptr) {
+        return nullptr;
+    }
+    header->size = size;
+    return header + 1;
+}
+
+void *PixelBufferPool::reallocate(void *pointer, size_t newSize) {
+    if (pointer == nullptr) {
+        return allocate(newSize);
+    }
+    BlockHeader *header = static_cast<BlockHeader *>(pointer) - 1;
+    if (header->size == newSize) {
+        return pointer;
+    }
+
+    void *newPointer = allocate(newSize);
+    if (newPointer != nullptr) {
+        std::memcpy(newPointer, pointer, std::min(header->size, newSize));
+        release(pointer);
+    }
+    return newPointer;
+}
+
+void PixelBufferPool::release(void *pointer) {
+    if (pointer != nullptr) {
+        releaseBlock(static_cast<BlockHeader *>(pointer) - 1, false);
+    }
+}
+
+void PixelBufferPool::recycle(void *pointer) {
+    if (pointer != nullptr) {
+        releaseBlock(static_cast<BlockHeader *>(pointer) - 1, true);
+    }
+}
+
+void PixelBufferPool::releaseBlock(BlockHeader *header, bool isSizeClass) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = isSizeClass ? idleBlocks.try_emplace(header->size).first : idleBlocks.find(header->size);
+        if (it != idleBlocks.end() && statistics.idleBytes + header->size <= maxIdleBytes) {
+            it->second.push_back(header);
+            statistics.idleBytes += header->size;
+            return;
+        }
+    }
+    std::free(header);
+}
+
+void PixelBufferPool::setMaxIdleBytes(size_t maxBytes) {
+    std::vector<BlockHeader *> blocksToFree;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        maxIdleBytes = maxBytes;
+        for (auto &sizeClass: idleBlocks) {
+            while (statistics.idleBytes > maxIdleBytes && !sizeClass.second.empty()) {
+                blocksToFree.push_back(sizeClass.second.back());
+                sizeClass.second.pop_back();
+                statistics.idleBytes -= sizeClass.first;
+            }
+        }
+    }
+    for (BlockHeader *header: blocksToFree) {
+        std::free(header);
+    }
+}
+
+PixelBufferPoolStatistics PixelBufferPool::getStatistics() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return statistics;
+}
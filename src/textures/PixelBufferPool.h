@@ -0,0 +1,76 @@
+#ifndef EARTH_VISUALIZATION_PIXELBUFFERPOOL_H
+#define EARTH_VISUALIZATION_PIXELBUFFERPOOL_H
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+
+struct PixelBufferPoolStatistics {
+    // Allocations of a known size class served from, or missing in, the idle buffers
+    unsigned long hits = 0;
+    unsigned long misses = 0;
+    size_t idleBytes = 0;
+};
+
+/**
+ * Recycles the multi-megabyte buffers the decoded tiles are stored in.
+ *
+ * All allocations of stb_image go through the pool (see stb_image.cpp). A size
+ * class is created when a decoded tile's pixels are recycled after the upload;
+ * since all tiles of an atlas have the same size and number of channels, the
+ * next decode of such a tile gets the buffer back instead of a fresh allocation.
+ * Temporary buffers of the decoder, whose sizes vary, are freed as usual.
+ *
+ * Idle buffers are kept only up to a limit on their total size.
+ */
+class PixelBufferPool {
+private:
+    // Precedes each block; keeps the returned memory 16-byte aligned
+    struct alignas(16) BlockHeader {
+        size_t size;
+    };
+
+    std::mutex mutex;
+    // Idle blocks by their size. The keys are the known size classes.
+    std::unordered_map<size_t, std::vector<BlockHeader *>> idleBlocks;
+    size_t maxIdleBytes;
+    PixelBufferPoolStatistics statistics;
+
+    void releaseBlock(BlockHeader *header, bool isSizeClass);
+
+public:
+    explicit PixelBufferPool(size_t maxIdleBytes = 128 * 1024 * 1024) : maxIdleBytes(maxIdleBytes) {
+    }
+
+    ~PixelBufferPool();
+
+    PixelBufferPool(const PixelBufferPool &) = delete;
+
+    PixelBufferPool &operator=(const PixelBufferPool &) = delete;
+
+    /**
+     * The pool used by stb_image.
+     */
+    static PixelBufferPool &getInstance();
+
+    void *allocate(size_t size);
+
+    void *reallocate(void *pointer, size_t newSize);
+
+    /**
+     * Frees the buffer, or keeps it for later if it belongs to a size class.
+     */
+    void release(void *pointer);
+
+    /**
+     * Keeps the pixels of a tile for later and makes their size a size class.
+     */
+    void recycle(void *pointer);
+
+    void setMaxIdleBytes(size_t maxBytes);
+
+    [[nodiscard]] PixelBufferPoolStatistics getStatistics();
+};
+
+#endif //EARTH_VISUALIZATION_PIXELBUFFERPOOL_H
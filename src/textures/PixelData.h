@@ -0,0 +1,23 @@
+#ifndef EARTH_VISUALIZATION_PIXELDATA_H
+#define EARTH_VISUALIZATION_PIXELDATA_H
+
+#include <memory>
+#include "PixelBufferPool.h"
+
+/**
+ * Returns pixels decoded by stb_image to the pool, so that the next decoded tile
+ * of the same size can reuse the buffer.
+ */
+struct StbiImageDeleter {
+    void operator()(unsigned char *pixels) const {
+        PixelBufferPool::getInstance().recycle(pixels);
+    }
+};
+
+/**
+ * Decoded pixels of a texture with its mipmaps. The buffer is handed over from the
+ * loader to the texture and recycled after the upload without being copied.
+ */
+typedef std::unique_ptr<unsigned char[], StbiImageDeleter> PixelData;
+
+#endif //EARTH_VISUALIZATION_PIXELDATA_H
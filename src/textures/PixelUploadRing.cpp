@@ -0,0 +1,105 @@
+#include "PixelUploadRing.h"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+void PixelUploadRing::initialize() {
+    std::lock_guard<std::mutex> lock(mutex);
+    assert(bufferId == 0);
+
+    // The buffer stays mapped for its whole lifetime. Coherent mapping makes
+    // the copies visible to uploads issued afterwards without explicit flushes.
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glCreateBuffers(1, &bufferId);
+    glNamedBufferStorage(bufferId, static_cast<GLsizeiptr>(capacity), nullptr, flags);
+    mappedData = static_cast<unsigned char *>(
+            glMapNamedBufferRange(bufferId, 0, static_cast<GLsizeiptr>(capacity), flags));
+
+    if (mappedData == nullptr) {
+        std::cerr << "Failed to map the pixel upload buffer: " << glGetError() << std::endl;
+    }
+    head = 0;
+    allocations.clear();
+}
+
+void PixelUploadRing::destroy() {
+    std::unique_lock<std::mutex> lock(mutex);
+    writersFinished.wait(lock, [this] { return activeWriters == 0; });
+
+    if (bufferId != 0) {
+        glUnmapNamedBuffer(bufferId);
+        glDeleteBuffers(1, &bufferId);
+    }
+    bufferId = 0;
+    mappedData = nullptr;
+    head = 0;
+    allocations.clear();
+}
+
+bool PixelUploadRing::findFreeOffset(size_t size, size_t &offset) const {
+    if (allocations.empty()) {
+        offset = 0;
+        return size <= capacity;
+    }
+
+    size_t tail = allocations.front().offset;
+    if (head > tail) {
+        // The free space is after the head and before the tail
+        if (head + size <= capacity) {
+            offset = head;
+            return true;
+        }
+        offset = 0;
+        return size <= tail;
+    }
+    // The ring has wrapped around, or it is full if the head caught up with the tail
+    offset = head;
+    return head < tail && head + size <= tail;
+}
+
+PixelUploadRegion PixelUploadRing::reserve(size_t size) {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t offset;
+    if (mappedData == nullptr || size == 0 || !findFreeOffset(size, offset)) {
+        return {};
+    }
+
+    size_t alignedSize = (size + alignment - 1) / alignment * alignment;
+    allocations.push_back({offset, alignedSize, false});
+    head = std::min(offset + alignedSize, capacity);
+    activeWriters++;
+
+    PixelUploadRegion region;
+    region.offset = offset;
+    region.size = size;
+    region.data = mappedData + offset;
+    return region;
+}
+
+void PixelUploadRing::finishWriting() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        assert(activeWriters > 0);
+        activeWriters--;
+    }
+    writersFinished.notify_all();
+}
+
+void PixelUploadRing::release(const PixelUploadRegion &region) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = std::find_if(allocations.begin(), allocations.end(), [&](const Allocation &allocation) {
+        return allocation.offset == region.offset && !allocation.isReleased;
+    });
+    if (it == allocations.end()) {
+        return;
+    }
+    it->isReleased = true;
+
+    // Reclaim the space of the oldest regions
+    while (!allocations.empty() && allocations.front().isReleased) {
+        allocations.pop_front();
+    }
+    if (allocations.empty()) {
+        head = 0;
+    }
+}
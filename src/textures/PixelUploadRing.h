@@ -0,0 +1,96 @@
+#ifndef EARTH_VISUALIZATION_PIXELUPLOADRING_H
+#define EARTH_VISUALIZATION_PIXELUPLOADRING_H
+
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include "../include/glad/glad.h"
+
+/**
+ * A part of the staging buffer holding the pixels of a single texture.
+ */
+struct PixelUploadRegion {
+    size_t offset = 0;
+    size_t size = 0;
+    unsigned char *data = nullptr;
+
+    [[nodiscard]] bool isValid() const {
+        return data != nullptr;
+    }
+};
+
+/**
+ * A persistently mapped pixel unpack buffer used as a ring of staging regions.
+ *
+ * Loader threads decode a texture and copy its pixels straight into a reserved
+ * region. The render thread then uploads the region into a texture array with
+ * glTextureSubImage3D, which returns without waiting for the copy, and releases
+ * the region once the fence placed after the upload has signalled.
+ *
+ * Regions are reserved at the head of the ring and reclaimed from its tail.
+ * A region released out of order is reclaimed as soon as all older regions
+ * have been released too.
+ */
+class PixelUploadRing {
+private:
+    struct Allocation {
+        size_t offset;
+        size_t size;
+        bool isReleased;
+    };
+
+    // Keeps the regions aligned for fast copies
+    static const size_t alignment = 64;
+
+    size_t capacity;
+    unsigned int bufferId = 0;
+    unsigned char *mappedData = nullptr;
+    size_t head = 0;
+    std::deque<Allocation> allocations;
+    // The number of loader threads still copying pixels into their regions
+    int activeWriters = 0;
+    std::mutex mutex;
+    std::condition_variable writersFinished;
+
+    bool findFreeOffset(size_t size, size_t &offset) const;
+
+public:
+    explicit PixelUploadRing(size_t capacity) : capacity(capacity) {
+    }
+
+    /**
+     * Creates and maps the buffer. Must be called from the thread owning the OpenGL context.
+     */
+    void initialize();
+
+    /**
+     * Waits for loader threads to finish their copies, then unmaps and deletes the buffer.
+     * Further reservations fail.
+     */
+    void destroy();
+
+    /**
+     * Reserves a region for the given number of bytes. Safe to call from any thread.
+     * Each valid region must be followed by a call to finishWriting.
+     *
+     * @return An invalid region if the ring is full or not initialized.
+     */
+    PixelUploadRegion reserve(size_t size);
+
+    /**
+     * Signals that the pixels have been copied into the region.
+     */
+    void finishWriting();
+
+    /**
+     * Returns the region to the ring once the GPU no longer reads from it.
+     */
+    void release(const PixelUploadRegion &region);
+
+    [[nodiscard]] unsigned int getBufferId() const {
+        return bufferId;
+    }
+};
+
+#endif //EARTH_VISUALIZATION_PIXELUPLOADRING_H
@@ -12,22 +12,67 @@
 #include <vector>
 #include "../tiling/Resolution.h"
 #include "../include/glad/glad.h"
+#include "TextureArrayPool.h"
+#include "PixelUploadRing.h"
+#include "PixelData.h"
+#include "TilePack.h"
+#include "BlockCompression.h"
+#include "MipChain.h"
+
+// Not part of the core profile, but supported by all desktop drivers including Mesa
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
 
 class Texture {
 private:
     bool isGlPrepared = false;
     std::string path;
-    std::vector<unsigned char> data;
+    // The base level and the remaining levels of the mip chain, until uploaded
+    PixelData data;
+    PixelData mipLevels;
     Resolution resolution; // Resolution in pixels
     int channels;
+    // The number of mipmap levels the data holds and the texture array stores
+    int numMipLevels = 1;
     glm::vec2 geodeticOffset; // Offset of this texture on the ellipsoid
     glm::vec2 geodeticSize; // Width in longitude and latitude
     glm::vec2 textureGridSize;
 
-    unsigned int textureId;
+    // The layer of the texture array the texture resides in
+    TextureArraySlot slot;
+    // The pack holding the decoded pixels, if the texture is not stored as an image file
+    std::shared_ptr<const TilePack> pack;
+    unsigned int packTileIndex = 0;
 
-    void freeData() {
-        data.clear();
+    /**
+     * Uploads all mipmap levels into the layer of the texture array. The pointers are
+     * offsets instead if a pixel unpack buffer is bound.
+     * @param baseLevel The pixels of the first level.
+     * @param otherLevels The remaining levels, one after another.
+     */
+    void uploadMipChain(const unsigned char *baseLevel, const unsigned char *otherLevels) {
+        auto width = resolution.getWidth();
+        auto height = resolution.getHeight();
+        TextureCompression compression = getCompression();
+        size_t baseSize = BlockCompression::getLevelSize(compression, width, height, channels, 0);
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (int level = 0; level < numMipLevels; level++) {
+            const unsigned char *levelData = level == 0 ? baseLevel : otherLevels +
+                    (BlockCompression::getLevelOffset(compression, width, height, channels, level) - baseSize);
+            int levelWidth = MipChain::getLevelExtent(width, level);
+            int levelHeight = MipChain::getLevelExtent(height, level);
+            if (compression == TextureCompression::None) {
+                glTextureSubImage3D(slot.textureArrayId, level, 0, 0, slot.layer, levelWidth, levelHeight, 1,
+                                    getDataFormat(), GL_UNSIGNED_BYTE, levelData);
+            } else {
+                auto levelSize = static_cast<GLsizei>(
+                        BlockCompression::getLevelSize(compression, width, height, channels, level));
+                glCompressedTextureSubImage3D(slot.textureArrayId, level, 0, 0, slot.layer, levelWidth,
+                                              levelHeight, 1, getStorageFormat(), levelSize, levelData);
+            }
+        }
     }
 
 public:
@@ -42,79 +87,133 @@ public:
               channels(0) {
     }
 
-    void setData(std::vector<unsigned char> dataOther) {
-        data = std::move(dataOther);
+    /**
+     * Takes over the decoded pixels.
+     * @param otherLevels The levels after the base one, unless the texture has a single level.
+     */
+    void setData(PixelData baseLevel, PixelData otherLevels) {
+        data = std::move(baseLevel);
+        mipLevels = std::move(otherLevels);
     }
 
     void setChannels(int channelsValue) {
         channels = channelsValue;
     }
 
-    void loadIntoGL() {
-        assert(!data.empty());
-        assert(!isGlPrepared);
+    void setNumMipLevels(int numLevels) {
+        numMipLevels = numLevels;
+    }
 
-        auto width = resolution.getWidth();
-        auto height = resolution.getHeight();
+    /**
+     * Frees the decoded pixels, e.g., if they cannot be uploaded.
+     */
+    void freeData() {
+        data.reset();
+        mipLevels.reset();
+    }
 
-        int dataFormat = GL_RGB;
-        int storageFormat = GL_RGB8;
-        if (channels == 1) {
-            dataFormat = GL_RED;
-            storageFormat = GL_R8;
-        }
+    /**
+     * Loads the texture from a tile of a pack instead of the image file.
+     */
+    void setPackSource(std::shared_ptr<const TilePack> tilePack, unsigned int tileIndex) {
+        pack = std::move(tilePack);
+        packTileIndex = tileIndex;
+    }
 
-        glCreateTextures(GL_TEXTURE_2D, 1, &textureId);
+    /**
+     * Uploads the data into the given layer of a texture array and frees the CPU copy.
+     * The layer is allocated by the ResourceManager.
+     */
+    void loadIntoGL(const TextureArraySlot &textureArraySlot) {
+        assert(data);
+        assert(!isGlPrepared);
+        assert(textureArraySlot.isValid());
+
+        slot = textureArraySlot;
+        assert(mipLevels || numMipLevels == 1);
+        uploadMipChain(data.get(), mipLevels.get());
 
-        //Check for OpenGL errors
+        // Check for OpenGL errors after texture data loading
         GLenum error = glGetError();
         if (error != GL_NO_ERROR) {
-            std::cerr << "OpenGL error after glGenTextures: " << error << std::endl;
+            std::cerr << "OpenGL error after texture data loading: " << error << std::endl;
         }
 
-        glTextureParameteri(textureId, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTextureParameteri(textureId, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTextureParameteri(textureId, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTextureParameteri(textureId, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        // Anisotropic filtering improves the appearance of textures
-        // viewed at oblique angles, rather than straight-on.
-        glTextureParameterf(textureId, GL_TEXTURE_MAX_ANISOTROPY, 4);
+        freeData();
 
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-        glTextureStorage2D(textureId, 1, storageFormat, width, height);
-        glTextureSubImage2D(textureId, 0, 0, 0, width, height, dataFormat, GL_UNSIGNED_BYTE, data.data());
-        glGenerateTextureMipmap(textureId);
+        isGlPrepared = true;
+    }
 
-        // Check for OpenGL errors after texture data loading
-        error = glGetError();
+    /**
+     * Starts an asynchronous upload of pixels staged in a pixel unpack buffer into the given layer
+     * of a texture array. The texture cannot be used until finishUpload is called, which
+     * the ResourceManager does once the upload's fence has signalled.
+     */
+    void beginUpload(const TextureArraySlot &textureArraySlot, unsigned int pixelUnpackBuffer,
+                     const PixelUploadRegion &region) {
+        assert(!isGlPrepared);
+        assert(textureArraySlot.isValid());
+        assert(region.isValid());
+
+        assert(region.size == getResidentSize());
+        slot = textureArraySlot;
+
+        // The pixels are read from the bound buffer at the offset passed instead of a pointer
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelUnpackBuffer);
+        auto chain = reinterpret_cast<const unsigned char *>(region.offset);
+        uploadMipChain(chain, chain + BlockCompression::getLevelSize(getCompression(), resolution.getWidth(),
+                                                                     resolution.getHeight(), channels, 0));
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        GLenum error = glGetError();
         if (error != GL_NO_ERROR) {
-            std::cerr << "OpenGL error after texture data loading: " << error << std::endl;
+            std::cerr << "OpenGL error after starting a texture upload: " << error << std::endl;
         }
+    }
 
-        freeData();
-
+    /**
+     * Marks the texture as ready to use after its asynchronous upload has completed.
+     */
+    void finishUpload() {
+        assert(isUploadPending());
         isGlPrepared = true;
     }
 
+    /**
+     * Forgets the layer of the texture array. The layer is returned to the pool by the ResourceManager.
+     */
     void unloadFromGL() {
-        if (isGlPrepared) {
-            glDeleteTextures(1, &textureId);
-            isGlPrepared = false;
-        }
+        slot = TextureArraySlot();
+        isGlPrepared = false;
     }
 
     [[nodiscard]] bool isPreparedInGlContext() const {
         return isGlPrepared;
     }
 
+    /**
+     * Whether the texture has a layer assigned, but its pixels are still being uploaded.
+     */
+    [[nodiscard]] bool isUploadPending() const {
+        return slot.isValid() && !isGlPrepared;
+    }
+
     [[nodiscard]] bool isLoaded() const {
-        return !data.empty();
+        return data != nullptr;
     }
 
     [[nodiscard]] std::string getPath() const {
         return path;
     }
 
+    [[nodiscard]] const std::shared_ptr<const TilePack> &getPack() const {
+        return pack;
+    }
+
+    [[nodiscard]] unsigned int getPackTileIndex() const {
+        return packTileIndex;
+    }
+
     [[nodiscard]] Resolution getResolution() const {
         return resolution;
     }
@@ -135,8 +234,59 @@ public:
         return textureGridSize;
     }
 
-    [[nodiscard]] unsigned int &getTextureId() {
-        return textureId;
+    [[nodiscard]] int getChannels() const {
+        return channels;
+    }
+
+    [[nodiscard]] int getNumMipLevels() const {
+        return numMipLevels;
+    }
+
+    /**
+     * Textures from compressed tile packs are uploaded in the format of the pack.
+     */
+    [[nodiscard]] TextureCompression getCompression() const {
+        return pack ? pack->getCompression() : TextureCompression::None;
+    }
+
+    [[nodiscard]] GLenum getDataFormat() const {
+        return channels == 1 ? GL_RED : GL_RGB;
+    }
+
+    [[nodiscard]] GLenum getStorageFormat() const {
+        switch (getCompression()) {
+            case TextureCompression::BC1:
+                return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+            case TextureCompression::BC4:
+                return GL_COMPRESSED_RED_RGTC1;
+            case TextureCompression::BC7:
+                return GL_COMPRESSED_RGBA_BPTC_UNORM;
+            default:
+                return channels == 1 ? GL_R8 : GL_RGB8;
+        }
+    }
+
+    /**
+     * The number of bytes of video memory the texture takes up, including its mipmaps.
+     */
+    [[nodiscard]] size_t getResidentSize() const {
+        return BlockCompression::getChainSize(getCompression(), resolution.getWidth(), resolution.getHeight(),
+                                              channels, numMipLevels);
+    }
+
+    [[nodiscard]] const TextureArraySlot &getTextureArraySlot() const {
+        return slot;
+    }
+
+    /**
+     * The texture array containing this texture.
+     */
+    [[nodiscard]] unsigned int getTextureId() const {
+        return slot.textureArrayId;
+    }
+
+    [[nodiscard]] int getLayer() const {
+        return slot.layer;
     }
 };
 
@@ -0,0 +1,114 @@
+#include "TextureArrayPool.h"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+TextureArrayPool::TextureArray *TextureArrayPool::createTextureArray(int width, int height, GLenum storageFormat,
+                                                                    int numLevels, size_t layerSize,
+                                                                    int numLayers) {
+    int maxLayers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    numLayers = std::max(1, std::min(numLayers, maxLayers));
+
+    TextureArray textureArray;
+    textureArray.width = width;
+    textureArray.height = height;
+    textureArray.storageFormat = storageFormat;
+    textureArray.numLevels = numLevels;
+    textureArray.numLayers = numLayers;
+    textureArray.layerSize = layerSize;
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &textureArray.textureId);
+
+    glTextureParameteri(textureArray.textureId, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(textureArray.textureId, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(textureArray.textureId, GL_TEXTURE_MIN_FILTER,
+                        numLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTextureParameteri(textureArray.textureId, GL_TEXTURE_MAX_LEVEL, numLevels - 1);
+    glTextureParameteri(textureArray.textureId, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // Anisotropic filtering improves the appearance of textures
+    // viewed at oblique angles, rather than straight-on.
+    glTextureParameterf(textureArray.textureId, GL_TEXTURE_MAX_ANISOTROPY, 4);
+
+    // Errors of earlier calls must not be mistaken for a failed allocation
+    while (glGetError() != GL_NO_ERROR) {
+    }
+    glTextureStorage3D(textureArray.textureId, numLevels, storageFormat, width, height, numLayers);
+
+    // Typically GL_OUT_OF_MEMORY; the layers would have no storage to sample
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR) {
+        std::cerr << "OpenGL error after creating a texture array: " << error << std::endl;
+        glDeleteTextures(1, &textureArray.textureId);
+        return nullptr;
+    }
+
+    // Hand out the lowest layers first
+    for (int layer = numLayers - 1; layer >= 0; layer--) {
+        textureArray.freeLayers.push_back(layer);
+    }
+    allocatedBytes += layerSize * numLayers;
+    textureArrays.push_back(std::move(textureArray));
+    return &textureArrays.back();
+}
+
+TextureArraySlot TextureArrayPool::allocate(int width, int height, GLenum storageFormat, int numLevels,
+                                            size_t layerSize, int numLayers) {
+    auto it = std::find_if(textureArrays.begin(), textureArrays.end(), [&](const TextureArray &textureArray) {
+        return textureArray.isOfKind(width, height, storageFormat, numLevels) && !textureArray.freeLayers.empty();
+    });
+    TextureArray *textureArray = it != textureArrays.end() ? &*it
+                                                           : createTextureArray(width, height, storageFormat,
+                                                                                numLevels, layerSize, numLayers);
+    if (textureArray == nullptr) {
+        return {};
+    }
+
+    TextureArraySlot slot;
+    slot.textureArrayId = textureArray->textureId;
+    slot.layer = textureArray->freeLayers.back();
+    textureArray->freeLayers.pop_back();
+    numAllocatedLayers++;
+    return slot;
+}
+
+bool TextureArrayPool::hasFreeLayer(int width, int height, GLenum storageFormat, int numLevels) const {
+    return std::any_of(textureArrays.begin(), textureArrays.end(), [&](const TextureArray &textureArray) {
+        return textureArray.isOfKind(width, height, storageFormat, numLevels) && !textureArray.freeLayers.empty();
+    });
+}
+
+void TextureArrayPool::free(const TextureArraySlot &slot) {
+    if (!slot.isValid()) {
+        return;
+    }
+    auto it = std::find_if(textureArrays.begin(), textureArrays.end(), [&](const TextureArray &textureArray) {
+        return textureArray.textureId == slot.textureArrayId;
+    });
+    assert(it != textureArrays.end());
+    if (it != textureArrays.end()) {
+        it->freeLayers.push_back(slot.layer);
+        numAllocatedLayers--;
+    }
+}
+
+bool TextureArrayPool::releaseEmptyArray() {
+    auto it = std::find_if(textureArrays.begin(), textureArrays.end(), [](const TextureArray &textureArray) {
+        return textureArray.isEmpty();
+    });
+    if (it == textureArrays.end()) {
+        return false;
+    }
+    glDeleteTextures(1, &it->textureId);
+    allocatedBytes -= it->layerSize * it->numLayers;
+    textureArrays.erase(it);
+    return true;
+}
+
+void TextureArrayPool::releaseAll() {
+    for (const TextureArray &textureArray: textureArrays) {
+        glDeleteTextures(1, &textureArray.textureId);
+    }
+    textureArrays.clear();
+    numAllocatedLayers = 0;
+    allocatedBytes = 0;
+}
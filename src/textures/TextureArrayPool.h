@@ -0,0 +1,115 @@
+#ifndef EARTH_VISUALIZATION_TEXTUREARRAYPOOL_H
+#define EARTH_VISUALIZATION_TEXTUREARRAYPOOL_H
+
+#include <cstddef>
+#include <vector>
+#include "../include/glad/glad.h"
+
+/**
+ * A layer of a texture array holding a single resident texture.
+ */
+struct TextureArraySlot {
+    unsigned int textureArrayId = 0;
+    int layer = -1;
+
+    [[nodiscard]] bool isValid() const {
+        return textureArrayId != 0;
+    }
+};
+
+/**
+ * Resident textures stored as layers of GL_TEXTURE_2D_ARRAY textures.
+ *
+ * All tiles of a texture atlas level have the same size, so each combination of
+ * the tile size and the storage format (e.g., RGB8 for day and night textures,
+ * R8 for height maps) gets its own arrays. Tiles sharing an array can be drawn
+ * without rebinding textures; the shader selects the tile by its layer index.
+ *
+ * Arrays have an immutable size and number of mipmap levels, and their memory is
+ * committed for all layers when they are created. When all layers of the arrays
+ * of a given kind are taken, another array is created. Arrays whose layers are
+ * all free are kept for reuse until the caller releases them.
+ */
+class TextureArrayPool {
+private:
+    struct TextureArray {
+        unsigned int textureId = 0;
+        int width = 0;
+        int height = 0;
+        GLenum storageFormat = 0;
+        int numLevels = 1;
+        int numLayers = 0;
+        // The bytes of a single layer including its mipmaps
+        size_t layerSize = 0;
+        std::vector<int> freeLayers;
+
+        [[nodiscard]] bool isOfKind(int otherWidth, int otherHeight, GLenum otherStorageFormat,
+                                    int otherNumLevels) const {
+            return width == otherWidth && height == otherHeight && storageFormat == otherStorageFormat &&
+                   numLevels == otherNumLevels;
+        }
+
+        [[nodiscard]] bool isEmpty() const {
+            return static_cast<int>(freeLayers.size()) == numLayers;
+        }
+    };
+
+    std::vector<TextureArray> textureArrays;
+    unsigned int numAllocatedLayers = 0;
+    size_t allocatedBytes = 0;
+
+    /**
+     * @return Null if the driver could not allocate the storage.
+     */
+    TextureArray *createTextureArray(int width, int height, GLenum storageFormat, int numLevels,
+                                     size_t layerSize, int numLayers);
+
+public:
+    /**
+     * Reserves a layer for a texture of the given size, format and number of mipmap levels.
+     * @param layerSize The bytes of the texture including its mipmaps.
+     * @param numLayers The number of layers of a new array if none of the existing ones has
+     * a free layer. Clamped to GL_MAX_ARRAY_TEXTURE_LAYERS.
+     * @return An invalid slot if a new array was needed, but its storage could not be allocated.
+     */
+    TextureArraySlot allocate(int width, int height, GLenum storageFormat, int numLevels, size_t layerSize,
+                              int numLayers);
+
+    /**
+     * Whether a texture of the given kind gets a layer without creating another array.
+     */
+    [[nodiscard]] bool hasFreeLayer(int width, int height, GLenum storageFormat, int numLevels) const;
+
+    /**
+     * Returns the layer to the pool. The array itself stays allocated.
+     */
+    void free(const TextureArraySlot &slot);
+
+    /**
+     * Deletes one of the arrays none of whose layers are taken.
+     * @return False if there is no such array.
+     */
+    bool releaseEmptyArray();
+
+    /**
+     * Deletes all texture arrays.
+     */
+    void releaseAll();
+
+    [[nodiscard]] unsigned int getNumTextureArrays() const {
+        return textureArrays.size();
+    }
+
+    [[nodiscard]] unsigned int getNumAllocatedLayers() const {
+        return numAllocatedLayers;
+    }
+
+    /**
+     * The video memory committed to the arrays, including their free layers.
+     */
+    [[nodiscard]] size_t getAllocatedBytes() const {
+        return allocatedBytes;
+    }
+};
+
+#endif //EARTH_VISUALIZATION_TEXTUREARRAYPOOL_H
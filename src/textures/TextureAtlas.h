@@ -17,6 +17,17 @@
 #include <iostream>
 #include <dirent.h>
 
+/**
+ * The position of a texture tile encoded in its file name.
+ */
+struct TextureFileName {
+    int xIndex;
+    int yIndex;
+    int xTiles;
+    int yTiles;
+    int imageWidth;
+};
+
 class TextureAtlas {
 private:
     std::vector<std::vector<std::vector<std::shared_ptr<Texture>>>> textures; // A 3D vector to store textures.
@@ -63,48 +74,80 @@ private:
         texturePath += "/";
         texturePath += fileName;
 
-        // Parse the file name to extract relevant information.
-        std::vector<std::string> tokens;
-        std::istringstream tokenStream(fileName);
-        std::string token;
-        while (std::getline(tokenStream, token, '_')) {
-            tokens.push_back(token);
+        TextureFileName parsedName{};
+        if (parseTextureFileName(fileName, parsedName)) {
+            registerTexture(std::move(texturePath), level, parsedName);
         }
+    }
 
-        if (tokens.size() == 8) {
-            int x_index = std::atoi(tokens[1].c_str());
-            int y_index = std::atoi(tokens[2].c_str());
-            int x_tiles = std::atoi(tokens[3].c_str());
-            int y_tiles = std::atoi(tokens[4].c_str());
-            int image_width = std::atoi(tokens[7].c_str());
+    std::shared_ptr<Texture> registerTexture(std::string texturePath, int level, const TextureFileName &name) {
+        int x_index = name.xIndex;
+        int y_index = name.yIndex;
+        int x_tiles = name.xTiles;
+        int y_tiles = name.yTiles;
 
-            assert(x_index < x_tiles && x_tiles > 0);
-            assert(y_index < y_tiles && y_tiles > 0);
-            assert(image_width > 0);
+        double longitudeOffset = static_cast<double>(x_index) / x_tiles * 360 - 180;
+        double latitudeOffset = static_cast<double>(y_index) / y_tiles * 180 - 90;
+        double longitudeWidth = 1.0 / x_tiles * 360;
+        double latitudeWidth = 1.0 / y_tiles * 180;
 
-            double longitudeOffset = static_cast<double>(x_index) / x_tiles * 360 - 180;
-            double latitudeOffset = static_cast<double>(y_index) / y_tiles * 180 - 90;
-            double longitudeWidth = 1.0 / x_tiles * 360;
-            double latitudeWidth = 1.0 / y_tiles * 180;
+        auto geodeticOffset = glm::vec2(longitudeOffset, latitudeOffset);
+        auto geodeticSize = glm::vec2(longitudeWidth, latitudeWidth);
+        auto numTextureTiles = glm::vec2(x_tiles, y_tiles);
+        auto texture = std::make_shared<Texture>(
+                std::move(texturePath), name.imageWidth,
+                geodeticOffset, geodeticSize, numTextureTiles);
 
-            // Assuming you have a function to create a Texture instance from the file.
-            auto geodeticOffset = glm::vec2(longitudeOffset, latitudeOffset);
-            auto geodeticSize = glm::vec2(longitudeWidth, latitudeWidth);
-            auto numTextureTiles = glm::vec2(x_tiles, y_tiles);
-            auto texture = std::make_shared<Texture>(
-                    std::move(texturePath), image_width,
-                    geodeticOffset, geodeticSize, numTextureTiles);
+        // Ensure the vectors are appropriately sized.
+        ensureVectorSize(textures[level], x_tiles, y_tiles);
 
-            // Ensure the vectors are appropriately sized.
-            ensureVectorSize(textures[level], x_tiles, y_tiles);
+        // Add the texture to the appropriate location in the textures vector.
+        textures[level][x_index][y_index] = texture;
+        numRegisteredTextures++;
+        return texture;
+    }
 
-            // Add the texture to the appropriate location in the textures vector.
-            textures[level][x_index][y_index] = texture;
-            numRegisteredTextures++;
-        }
+    /**
+     * Orders the levels from the coarsest to the most detailed one, so that atlases
+     * of different layers agree on the level indices regardless of the order
+     * in which their levels were found.
+     */
+    void sortLevelsByDetail() {
+        std::stable_sort(textures.begin(), textures.end(), [](const auto &first, const auto &second) {
+            return first.size() < second.size();
+        });
     }
 
 public:
+    /**
+     * Parses a file name in the format
+     * '{name}_{x_index}_{y_index}_{x_tiles}_{y_tiles}_{original_width}_{original_height}_{image_width}.png'.
+     *
+     * @return False if the name does not follow the format.
+     */
+    static bool parseTextureFileName(const std::string &fileName, TextureFileName &parsedName) {
+        std::vector<std::string> tokens;
+        std::istringstream tokenStream(fileName);
+        std::string token;
+        while (std::getline(tokenStream, token, '_')) {
+            tokens.push_back(token);
+        }
+        if (tokens.size() != 8) {
+            return false;
+        }
+
+        parsedName.xIndex = std::atoi(tokens[1].c_str());
+        parsedName.yIndex = std::atoi(tokens[2].c_str());
+        parsedName.xTiles = std::atoi(tokens[3].c_str());
+        parsedName.yTiles = std::atoi(tokens[4].c_str());
+        parsedName.imageWidth = std::atoi(tokens[7].c_str());
+
+        assert(parsedName.xIndex < parsedName.xTiles && parsedName.xTiles > 0);
+        assert(parsedName.yIndex < parsedName.yTiles && parsedName.yTiles > 0);
+        assert(parsedName.imageWidth > 0);
+        return true;
+    }
+
     /**
      * Reads the directory for textures. It expects subfolders, each representing
      * a single level. The subfolders should contain images in the format
@@ -118,7 +161,7 @@ public:
         // The textures 3D vector is organized as follows:
         // textures[level][x_index][y_index]
 
-        // Level 0 is the most detailed level.
+        // The levels are ordered from the coarsest to the most detailed one.
         // x_index and y_index represent the tile's position in longitude and latitude axes.
 
         // Open the directory for reading.
@@ -129,7 +172,7 @@ public:
         }
 
         // Loop through files in the directory.
-        int level = -1;
+        int level = static_cast<int>(textures.size()) - 1;
         struct dirent *entry;
         while ((entry = readdir(directory))) {
             // Check if the entry is a directory and skip ".", ".." entries.
@@ -146,12 +189,70 @@ public:
             }
         }
         closedir(directory);
+        sortLevelsByDetail();
 
         if (numRegisteredTextures == 0) {
             std::cout << "No textures found in " << path << std::endl;
         }
     }
 
+    /**
+     * Registers the tiles of a tile pack instead of a directory tree. The textures
+     * are read from the memory-mapped pack rather than decoded from image files.
+     *
+     * @return False if the pack cannot be opened.
+     */
+    bool registerPack(const std::string &path) {
+        std::shared_ptr<const TilePack> pack = TilePack::open(path);
+        if (!pack) {
+            return false;
+        }
+
+        // Each distinct grid of tiles is a level
+        std::vector<uint32_t> levelTiles;
+        for (unsigned int i = 0; i < pack->getNumTiles(); i++) {
+            levelTiles.push_back(pack->getEntry(i).xTiles);
+        }
+        std::sort(levelTiles.begin(), levelTiles.end());
+        levelTiles.erase(std::unique(levelTiles.begin(), levelTiles.end()), levelTiles.end());
+        int firstLevel = static_cast<int>(textures.size());
+        textures.resize(textures.size() + levelTiles.size());
+
+        for (unsigned int i = 0; i < pack->getNumTiles(); i++) {
+            const TilePackEntry &entry = pack->getEntry(i);
+            auto levelIt = std::lower_bound(levelTiles.begin(), levelTiles.end(), entry.xTiles);
+            int level = firstLevel + static_cast<int>(levelIt - levelTiles.begin());
+
+            TextureFileName name{};
+            name.xIndex = static_cast<int>(entry.xIndex);
+            name.yIndex = static_cast<int>(entry.yIndex);
+            name.xTiles = static_cast<int>(entry.xTiles);
+            name.yTiles = static_cast<int>(entry.yTiles);
+            name.imageWidth = static_cast<int>(entry.width);
+            // The path only identifies the texture
+            std::string texturePath = path + ":" + std::to_string(i);
+            registerTexture(std::move(texturePath), level, name)->setPackSource(pack, i);
+        }
+        sortLevelsByDetail();
+
+        if (pack->getNumTiles() == 0) {
+            std::cout << "No textures found in " << path << std::endl;
+        }
+        return true;
+    }
+
+    /**
+     * Registers the tile pack '{path}.pack' if there is one, as its tiles need no decoding.
+     * Otherwise, reads the directory tree.
+     */
+    void registerTextures(const std::string &path) {
+        std::string packPath = path + ".pack";
+        if (std::ifstream(packPath).good() && registerPack(packPath)) {
+            return;
+        }
+        registerAvailableTextures(path);
+    }
+
     /**
      * Returns the number of levels of detail available.
      */
@@ -163,7 +264,7 @@ public:
      * Returns the number of tiles in both longitude and latitude axes for the most detailed level.
      */
     Resolution getMostDetailedLevelDimensions() {
-        return getLevelDimensions(0);
+        return getLevelDimensions(textures.size() - 1);
     }
 
     /**
@@ -181,9 +282,12 @@ public:
      * @return
      */
     std::shared_ptr<Texture> getTexture(unsigned int level, const Tile &tile) {
-        if (level < textures.size() && tile.getLongitude() >= -180 && tile.getLatitude() >= -90) {
-            int x_index = static_cast<int>((tile.getLongitude() + 180) / 360.0 * textures[level].size());
-            int y_index = static_cast<int>((tile.getLatitude() + 90) / 180.0 * textures[level][0].size());
+        // The centre of the tile is used to avoid rounding errors on the borders of the textures.
+        double longitudeCentre = tile.getLongitude() + tile.getLongitudeWidth() / 2.0;
+        double latitudeCentre = tile.getLatitude() + tile.getLatitudeWidth() / 2.0;
+        if (level < textures.size() && longitudeCentre >= -180 && latitudeCentre >= -90) {
+            int x_index = static_cast<int>((longitudeCentre + 180) / 360.0 * textures[level].size());
+            int y_index = static_cast<int>((latitudeCentre + 90) / 180.0 * textures[level][0].size());
 
             if (x_index < textures[level].size() && y_index < textures[level][0].size()) {
                 return textures[level][x_index][y_index];
@@ -0,0 +1,212 @@
+#include "TilePack.h"
+#include "MipChain.h"
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+constexpr char TilePack::magic[4];
+
+// Larger tiles are not supported by the GPUs anyway, and their sizes could overflow
+static const uint32_t maxTileWidth = 1 << 15;
+
+/**
+ * Whether the entry describes a mip chain the rest of the pack can be trusted to read,
+ * i.e., it lies within the file and has the size its dimensions and format imply.
+ */
+static bool isValidEntry(const TilePackEntry &entry, TextureCompression compression, size_t mappedSize) {
+    if (entry.width == 0 || entry.width > maxTileWidth || entry.height == 0 || entry.height > maxTileWidth ||
+        entry.channels < 1 || entry.channels > 4 ||
+        !BlockCompression::isCompatible(compression, static_cast<int>(entry.channels))) {
+        return false;
+    }
+    auto width = static_cast<int>(entry.width);
+    auto height = static_cast<int>(entry.height);
+    auto channels = static_cast<int>(entry.channels);
+    if (entry.numMipLevels < 1 || entry.numMipLevels > static_cast<uint32_t>(MipChain::getNumLevels(width, height))) {
+        return false;
+    }
+    auto numMipLevels = static_cast<int>(entry.numMipLevels);
+    // Written so that the sum cannot overflow
+    return entry.size == BlockCompression::getChainSize(compression, width, height, channels, numMipLevels) &&
+           entry.size <= mappedSize && entry.offset <= mappedSize - entry.size;
+}
+
+TilePack::~TilePack() {
+    if (mappedData != nullptr) {
+        munmap(const_cast<unsigned char *>(mappedData), mappedSize);
+    }
+}
+
+std::shared_ptr<const TilePack> TilePack::open(const std::string &path) {
+    std::shared_ptr<TilePack> pack(new TilePack(path));
+    if (!pack->map()) {
+        return nullptr;
+    }
+    return pack;
+}
+
+bool TilePack::map() {
+    int fileDescriptor = ::open(path.c_str(), O_RDONLY);
+    if (fileDescriptor < 0) {
+        std::cerr << "Failed to open tile pack: " << path << std::endl;
+        return false;
+    }
+    struct stat fileStatus{};
+    if (fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size < static_cast<off_t>(sizeof(Header))) {
+        std::cerr << "Invalid tile pack: " << path << std::endl;
+        close(fileDescriptor);
+        return false;
+    }
+
+    mappedSize = static_cast<size_t>(fileStatus.st_size);
+    void *data = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    // The mapping stays valid after closing the file
+    close(fileDescriptor);
+    if (data == MAP_FAILED) {
+        std::cerr << "Failed to map tile pack: " << path << std::endl;
+        return false;
+    }
+    mappedData = static_cast<const unsigned char *>(data);
+
+    Header header{};
+    std::memcpy(&header, mappedData, sizeof(Header));
+    size_t indexEnd = sizeof(Header) + static_cast<size_t>(header.numTiles) * sizeof(TilePackEntry);
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version ||
+        indexEnd > mappedSize) {
+        std::cerr << "Invalid tile pack: " << path << std::endl;
+        return false;
+    }
+    if (header.compression > static_cast<uint32_t>(TextureCompression::BC7)) {
+        std::cerr << "Unknown compression of tile pack: " << path << std::endl;
+        return false;
+    }
+    numTiles = header.numTiles;
+    compression = static_cast<TextureCompression>(header.compression);
+    entries = reinterpret_cast<const TilePackEntry *>(mappedData + sizeof(Header));
+
+    for (uint32_t i = 0; i < numTiles; i++) {
+        if (!isValidEntry(entries[i], compression, mappedSize)) {
+            std::cerr << "Tile " << i << " of the tile pack is corrupted: " << path << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+const unsigned char *TilePack::getMipLevel(unsigned int tileIndex, int level) const {
+    const TilePackEntry &entry = entries[tileIndex];
+    size_t offset = BlockCompression::getLevelOffset(compression, static_cast<int>(entry.width),
+                                                     static_cast<int>(entry.height),
+                                                     static_cast<int>(entry.channels), level);
+    return mappedData + entry.offset + offset;
+}
+
+static uint64_t alignOffset(uint64_t offset, uint64_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+TilePackWriter::TilePackWriter(const std::string &path, unsigned int numTiles, TextureCompression compression)
+        : numTiles(numTiles), compression(compression) {
+    file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        std::cerr << "Failed to create tile pack: " << path << std::endl;
+    }
+    entries.reserve(numTiles);
+    uint64_t indexEnd = sizeof(TilePack::Header) + static_cast<uint64_t>(numTiles) * sizeof(TilePackEntry);
+    nextOffset = alignOffset(indexEnd, TilePack::payloadAlignment);
+}
+
+TilePackWriter::~TilePackWriter() {
+    if (file != nullptr) {
+        std::fclose(file);
+    }
+}
+
+std::vector<unsigned char> TilePackWriter::encodeTile(TextureCompression compression, int width, int height,
+                                                      int channels, const unsigned char *pixels) {
+    if (!BlockCompression::isCompatible(compression, channels)) {
+        std::cerr << "Tiles with " << channels << " channels cannot be compressed in the format of the pack"
+                  << std::endl;
+        return {};
+    }
+
+    int numMipLevels = MipChain::getNumLevels(width, height);
+    std::vector<unsigned char> chain(MipChain::getChainSize(width, height, channels, numMipLevels));
+    std::memcpy(chain.data(), pixels, MipChain::getLevelSize(width, height, channels, 0));
+    MipChain::build(chain.data(), width, height, channels, numMipLevels);
+
+    if (compression != TextureCompression::None) {
+        std::vector<unsigned char> blocks(BlockCompression::getChainSize(compression, width, height, channels,
+                                                                         numMipLevels));
+        for (int level = 0; level < numMipLevels; level++) {
+            BlockCompression::encode(compression,
+                                     chain.data() + MipChain::getLevelOffset(width, height, channels, level),
+                                     MipChain::getLevelExtent(width, level), MipChain::getLevelExtent(height, level),
+                                     channels,
+                                     blocks.data() + BlockCompression::getLevelOffset(compression, width, height,
+                                                                                      channels, level));
+        }
+        chain = std::move(blocks);
+    }
+    return chain;
+}
+
+bool TilePackWriter::addTile(uint32_t xIndex, uint32_t yIndex, uint32_t xTiles, uint32_t yTiles,
+                             int width, int height, int channels, const unsigned char *pixels) {
+    if (file == nullptr || entries.size() >= numTiles) {
+        return false;
+    }
+    std::vector<unsigned char> chain = encodeTile(compression, width, height, channels, pixels);
+    return addEncodedTile(xIndex, yIndex, xTiles, yTiles, width, height, channels, chain);
+}
+
+bool TilePackWriter::addEncodedTile(uint32_t xIndex, uint32_t yIndex, uint32_t xTiles, uint32_t yTiles,
+                                    int width, int height, int channels, const std::vector<unsigned char> &chain) {
+    int numMipLevels = MipChain::getNumLevels(width, height);
+    if (file == nullptr || entries.size() >= numTiles || chain.empty() ||
+        chain.size() != BlockCompression::getChainSize(compression, width, height, channels, numMipLevels)) {
+        return false;
+    }
+
+    TilePackEntry entry{};
+    entry.xIndex = xIndex;
+    entry.yIndex = yIndex;
+    entry.xTiles = xTiles;
+    entry.yTiles = yTiles;
+    entry.width = static_cast<uint32_t>(width);
+    entry.height = static_cast<uint32_t>(height);
+    entry.channels = static_cast<uint32_t>(channels);
+    entry.numMipLevels = static_cast<uint32_t>(numMipLevels);
+    entry.offset = nextOffset;
+    entry.size = chain.size();
+
+    if (std::fseek(file, static_cast<long>(entry.offset), SEEK_SET) != 0 ||
+        std::fwrite(chain.data(), 1, chain.size(), file) != chain.size()) {
+        return false;
+    }
+    entries.push_back(entry);
+    nextOffset = alignOffset(entry.offset + entry.size, TilePack::payloadAlignment);
+    return true;
+}
+
+bool TilePackWriter::finish() {
+    if (file == nullptr || entries.size() != numTiles) {
+        return false;
+    }
+
+    TilePack::Header header{};
+    std::memcpy(header.magic, TilePack::magic, sizeof(header.magic));
+    header.version = TilePack::version;
+    header.numTiles = numTiles;
+    header.compression = static_cast<uint32_t>(compression);
+
+    bool isWritten = std::fseek(file, 0, SEEK_SET) == 0 &&
+                     std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                     std::fwrite(entries.data(), sizeof(TilePackEntry), entries.size(), file) == entries.size();
+    isWritten = std::fclose(file) == 0 && isWritten;
+    file = nullptr;
+    return isWritten;
+}
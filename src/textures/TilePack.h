@@ -0,0 +1,169 @@
+#ifndef EARTH_VISUALIZATION_TILEPACK_H
+#define EARTH_VISUALIZATION_TILEPACK_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <memory>
+#include "BlockCompression.h"
+
+/**
+ * Describes a tile stored in a tile pack. The position follows the file names of the
+ * texture directories: the tile has the index (xIndex, yIndex) in a grid of
+ * xTiles by yTiles tiles covering the whole ellipsoid.
+ */
+struct TilePackEntry {
+    uint32_t xIndex;
+    uint32_t yIndex;
+    uint32_t xTiles;
+    uint32_t yTiles;
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;
+    uint32_t numMipLevels;
+    // Location of the mip chain within the file
+    uint64_t offset;
+    uint64_t size;
+};
+
+/**
+ * A single file holding all tiles of one texture layer (e.g., day maps), decoded
+ * and ready to be uploaded.
+ *
+ * The file starts with a header and an index of TilePackEntry records, followed
+ * by the payloads. Each payload is the full mip chain of a tile (see MipChain) and
+ * starts at a page boundary. All tiles of a pack are either stored as raw pixels,
+ * or block-compressed in the same format, level by level. The file is memory-mapped, so reading a tile costs
+ * no more than touching its pages.
+ */
+class TilePack {
+private:
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t numTiles;
+        // A TextureCompression; zero (none) in packs predating compression
+        uint32_t compression;
+    };
+
+    std::string path;
+    const unsigned char *mappedData = nullptr;
+    size_t mappedSize = 0;
+    const TilePackEntry *entries = nullptr;
+    uint32_t numTiles = 0;
+    TextureCompression compression = TextureCompression::None;
+
+    friend class TilePackWriter;
+
+    static constexpr char magic[4] = {'E', 'V', 'T', 'P'};
+    static const uint32_t version = 1;
+    // Payloads are aligned to pages
+    static const uint64_t payloadAlignment = 4096;
+
+    explicit TilePack(std::string path) : path(std::move(path)) {
+    }
+
+    bool map();
+
+public:
+    ~TilePack();
+
+    TilePack(const TilePack &) = delete;
+
+    TilePack &operator=(const TilePack &) = delete;
+
+    /**
+     * Maps the pack into memory.
+     * @return Null if the file cannot be read or is not a valid pack.
+     */
+    static std::shared_ptr<const TilePack> open(const std::string &path);
+
+    [[nodiscard]] const std::string &getPath() const {
+        return path;
+    }
+
+    [[nodiscard]] unsigned int getNumTiles() const {
+        return numTiles;
+    }
+
+    [[nodiscard]] const TilePackEntry &getEntry(unsigned int tileIndex) const {
+        return entries[tileIndex];
+    }
+
+    [[nodiscard]] TextureCompression getCompression() const {
+        return compression;
+    }
+
+    /**
+     * The pixels, or the blocks if compressed, of a level of the tile's mip chain.
+     */
+    [[nodiscard]] const unsigned char *getMipLevel(unsigned int tileIndex, int level) const;
+};
+
+/**
+ * Writes a tile pack. The payloads are written as the tiles are added, so that
+ * only a single tile is kept in memory; the index is written at the end.
+ *
+ * Tiles can be encoded with encodeTile on other threads and added with addEncodedTile;
+ * adding is not thread-safe.
+ */
+class TilePackWriter {
+private:
+    std::FILE *file = nullptr;
+    uint32_t numTiles;
+    TextureCompression compression;
+    std::vector<TilePackEntry> entries;
+    uint64_t nextOffset;
+
+public:
+    /**
+     * @param numTiles The number of tiles that will be added.
+     * @param compression The format all tiles are encoded in.
+     */
+    TilePackWriter(const std::string &path, unsigned int numTiles,
+                   TextureCompression compression = TextureCompression::None);
+
+    ~TilePackWriter();
+
+    TilePackWriter(const TilePackWriter &) = delete;
+
+    TilePackWriter &operator=(const TilePackWriter &) = delete;
+
+    [[nodiscard]] bool isOpen() const {
+        return file != nullptr;
+    }
+
+    [[nodiscard]] TextureCompression getCompression() const {
+        return compression;
+    }
+
+    /**
+     * Computes the full mip chain of a tile and encodes it into the given format.
+     * @return The payload of the tile, or an empty vector if the format does not
+     * support the number of channels.
+     */
+    static std::vector<unsigned char> encodeTile(TextureCompression compression, int width, int height,
+                                                 int channels, const unsigned char *pixels);
+
+    /**
+     * Appends a tile encoded by encodeTile in the format of the pack.
+     */
+    bool addEncodedTile(uint32_t xIndex, uint32_t yIndex, uint32_t xTiles, uint32_t yTiles,
+                        int width, int height, int channels, const std::vector<unsigned char> &chain);
+
+    /**
+     * Computes the mip chain of the tile, encodes it if the pack is compressed,
+     * and appends it to the pack.
+     * @param pixels The tightly packed pixels of the full-resolution tile.
+     */
+    bool addTile(uint32_t xIndex, uint32_t yIndex, uint32_t xTiles, uint32_t yTiles,
+                 int width, int height, int channels, const unsigned char *pixels);
+
+    /**
+     * Writes the index and closes the file.
+     */
+    bool finish();
+};
+
+#endif //EARTH_VISUALIZATION_TILEPACK_H
@@ -0,0 +1,133 @@
+#ifndef EARTH_VISUALIZATION_BOUNDEDRING_H
+#define EARTH_VISUALIZATION_BOUNDEDRING_H
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <algorithm>
+
+/**
+ * A lock-free queue of a fixed capacity, passing values between threads.
+ *
+ * Any number of threads may push and pop at the same time, which covers both
+ * the many-producer/single-consumer channel of loaded textures and the
+ * single-producer/many-consumer channel of requests. Neither side ever waits
+ * for the other: pushing into a full ring or popping from an empty one fails.
+ *
+ * Each cell carries a sequence number telling whether it is ready to be
+ * written or read in the current lap around the ring (D. Vyukov's bounded
+ * MPMC queue). Values are moved in and out, so move-only types are supported.
+ */
+template<typename T>
+class BoundedRing {
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    // Keeps the positions of producers and consumers in separate cache lines
+    static const size_t cacheLineSize = 64;
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(cacheLineSize) std::atomic<size_t> pushPosition{0};
+    alignas(cacheLineSize) std::atomic<size_t> popPosition{0};
+
+    static size_t roundUpToPowerOfTwo(size_t value) {
+        size_t powerOfTwo = 1;
+        while (powerOfTwo < value) {
+            powerOfTwo <<= 1;
+        }
+        return powerOfTwo;
+    }
+
+public:
+    /**
+     * @param minCapacity The capacity is rounded up to a power of two.
+     */
+    explicit BoundedRing(size_t minCapacity)
+            : cells(new Cell[roundUpToPowerOfTwo(std::max<size_t>(minCapacity, 2))]),
+              mask(roundUpToPowerOfTwo(std::max<size_t>(minCapacity, 2)) - 1) {
+        for (size_t i = 0; i <= mask; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedRing(const BoundedRing &) = delete;
+
+    BoundedRing &operator=(const BoundedRing &) = delete;
+
+    /**
+     * Moves the value into the ring.
+     * @return False if the ring is full, in which case the value is left untouched.
+     */
+    bool tryPush(T &value) {
+        size_t position = pushPosition.load(std::memory_order_relaxed);
+        while (true) {
+            Cell &cell = cells[position & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+            if (difference == 0) {
+                // The cell is free in this lap; claim it
+                if (pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                // The cell still holds a value from the previous lap
+                return false;
+            } else {
+                position = pushPosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPush(T &&value) {
+        return tryPush(value);
+    }
+
+    /**
+     * Moves the oldest value out of the ring.
+     * @return False if the ring is empty.
+     */
+    bool tryPop(T &value) {
+        size_t position = popPosition.load(std::memory_order_relaxed);
+        while (true) {
+            Cell &cell = cells[position & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+            if (difference == 0) {
+                // The cell has been written in this lap; claim it
+                if (popPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.value);
+                    // Leave no moved-from resources behind and free the cell for the next lap
+                    cell.value = T();
+                    cell.sequence.store(position + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = popPosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Whether there is no value to pop. The answer may be outdated by the time it is
+     * returned, so it is only a hint, e.g., for a consumer deciding to go to sleep.
+     */
+    [[nodiscard]] bool isEmpty() const {
+        size_t position = popPosition.load(std::memory_order_relaxed);
+        size_t sequence = cells[position & mask].sequence.load(std::memory_order_acquire);
+        return static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1) < 0;
+    }
+
+    [[nodiscard]] size_t getCapacity() const {
+        return mask + 1;
+    }
+};
+
+#endif //EARTH_VISUALIZATION_BOUNDEDRING_H
@@ -0,0 +1,84 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int numThreads) {
+    for (unsigned int i = 1; i < numThreads; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isStopping = true;
+    }
+    workAvailable.notify_all();
+    for (std::thread &worker: workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::workerLoop() {
+    unsigned long lastGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workAvailable.wait(lock, [this, lastGeneration] {
+                return isStopping || generation != lastGeneration;
+            });
+            if (isStopping) {
+                break;
+            }
+            lastGeneration = generation;
+        }
+
+        runTasks();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            numActiveWorkers--;
+        }
+        workFinished.notify_one();
+    }
+}
+
+void ThreadPool::runTasks() {
+    while (true) {
+        size_t taskIndex = nextTask.fetch_add(1, std::memory_order_relaxed);
+        if (taskIndex >= numTasks) {
+            break;
+        }
+        (*task)(taskIndex);
+    }
+}
+
+void ThreadPool::parallelFor(size_t tasksCount, const std::function<void(size_t)> &taskFunction) {
+    if (workers.empty() || tasksCount <= 1) {
+        for (size_t i = 0; i < tasksCount; i++) {
+            taskFunction(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = &taskFunction;
+        numTasks = tasksCount;
+        nextTask.store(0, std::memory_order_relaxed);
+        numActiveWorkers = static_cast<unsigned int>(workers.size());
+        generation++;
+    }
+    workAvailable.notify_all();
+
+    runTasks();
+
+    // The loop is finished once all workers have stopped taking tasks.
+    std::unique_lock<std::mutex> lock(mutex);
+    workFinished.wait(lock, [this] { return numActiveWorkers == 0; });
+    task = nullptr;
+}
+
+unsigned int ThreadPool::getDefaultNumThreads(unsigned int maxThreads) {
+    unsigned int hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    return std::min(hardwareThreads, maxThreads);
+}
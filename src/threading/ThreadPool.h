@@ -0,0 +1,66 @@
+#ifndef EARTH_VISUALIZATION_THREADPOOL_H
+#define EARTH_VISUALIZATION_THREADPOOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+/**
+ * A fixed set of worker threads executing data-parallel loops.
+ *
+ * The calling thread takes part in the work, so a pool of N threads
+ * starts N - 1 workers. The workers sleep between the loops.
+ */
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workFinished;
+    // Incremented with every loop so that the workers can tell a new loop from the finished one.
+    unsigned long generation = 0;
+    bool isStopping = false;
+    unsigned int numActiveWorkers = 0;
+
+    // The current loop
+    const std::function<void(size_t)> *task = nullptr;
+    size_t numTasks = 0;
+    std::atomic<size_t> nextTask{0};
+
+    void workerLoop();
+
+    void runTasks();
+
+public:
+    /**
+     * @param numThreads The number of threads including the calling one.
+     */
+    explicit ThreadPool(unsigned int numThreads);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * Calls the task for each index in [0, numTasks) and blocks until all calls return.
+     * The tasks are distributed dynamically, so the order of the calls is not defined.
+     */
+    void parallelFor(size_t numTasks, const std::function<void(size_t)> &task);
+
+    [[nodiscard]] unsigned int getNumThreads() const {
+        return static_cast<unsigned int>(workers.size()) + 1;
+    }
+
+    /**
+     * The number of hardware threads, limited to the given maximum.
+     */
+    static unsigned int getDefaultNumThreads(unsigned int maxThreads);
+};
+
+
+#endif //EARTH_VISUALIZATION_THREADPOOL_H
@@ -5,40 +5,32 @@
 #include "Tile.h"
 #include "TileResources.h"
 #include "../utils.h"
+#include <limits>
+#include <algorithm>
+#include <glm/gtc/matrix_transform.hpp>
 
 
-std::shared_ptr<TileResources> Tile::getResources(
-        double screenSpaceWidth, double distanceToCamera, const Camera &camera) {
-    static double maxAngle = 0;
-
-//    double viewingAngle = getViewingAngle(camera);
-//    double viewingAngleNormalized = std::fabs(viewingAngle / 3.14159265 * 2);
-//    viewingAngleNormalized = std::min(viewingAngleNormalized / 0.4, 1.);
-//    double viewingCoeff = std::pow(1 - viewingAngleNormalized, 2); // -std::log(viewingAngleNormalized + 0.001);
-//    maxAngle = std::max(maxAngle, viewingAngleNormalized);
-//    std::cout << maxAngle << std::endl;
-
-    // Determine the appropriate level of detail (LOD) based on the screen-space error.
-    int level;
-    for (level = lodResources.size() - 1; level >= 0; level--) {
-        auto &lod = lodResources[level];
-        // Define the geometric error simply as the inverse of the number of triangles in a tile.
-        // times a coefficient depending on the viewing angle.
-
-        auto geometricError = 1.0 / lod->getMesh().size();
+bool Tile::isRefinementNeeded(double screenSpaceWidth, const Camera &camera) const {
+    if (!hasChildren()) {
+        return false;
+    }
+    double distanceToCamera = getDistanceToCamera(camera.getPosition());
+    double screenSpaceError = computeScreenSpaceError(screenSpaceWidth, distanceToCamera,
+                                                      glm::radians(camera.getFov()), getGeometricError());
+    return screenSpaceError > maxScreenSpaceError;
+}
 
-        double screenSpaceError = computeScreenSpaceError(screenSpaceWidth, distanceToCamera,
-                                                          camera.getFov(), geometricError);
-        if (screenSpaceError < 10.0) {
-            break;
-        }
-        // std::cout << "[" << level << "] screen space error: " << screenSpaceError << std::endl;
+double Tile::getDistanceToCamera(const glm::vec3 &cameraPosition) const {
+    double minDistance = std::numeric_limits<double>::infinity();
+    for (const auto &point: samplePoints) {
+        minDistance = std::min(minDistance, static_cast<double>(glm::length(cameraPosition - point)));
     }
-    // Avoid out-of-bounds indexing
-    level = std::max(level, 0);
-    level = std::min(level, static_cast<int>(lodResources.size() - 1));
-    //return lodResources[lodResources.size() - 1];
-    return lodResources[level];
+    // Avoid division by zero when the camera touches the tile
+    return std::max(minDistance, 1e-6);
+}
+
+double Tile::getGeometricError() const {
+    return tileWidth * resources->getMesh().getRelativeGeometricError();
 }
 
 /**
@@ -54,51 +46,45 @@ double Tile::getViewingAngle(const Camera &camera) const {
     return angle;
 }
 
-std::shared_ptr<TileResources> Tile::getResourcesByLevel(int level) {
-    assert(level < lodResources.size());
-    return lodResources[level];
-}
-
 bool Tile::isTileWithinTexture(const std::shared_ptr<Texture> &texture) const {
     auto textureOffset = texture->getGeodeticOffset();
     auto textureLongWidth = texture->getLongitudeWidth();
     auto textureLatWidth = texture->getLatitudeWidth();
 
-    if (this->longitude < textureOffset[0] ||
-        this->latitude < textureOffset[1]) {
+    // Test the centre of the tile, which is not sensitive to rounding errors
+    // on the shared borders of the tile and the texture.
+    double longitudeCentre = this->longitude + this->longitudeWidth / 2.0;
+    double latitudeCentre = this->latitude + this->latitudeWidth / 2.0;
+
+    if (longitudeCentre < textureOffset[0] ||
+        latitudeCentre < textureOffset[1]) {
         return false;
     }
-    if (this->longitude > textureOffset[0] + textureLongWidth ||
-        this->latitude > textureOffset[1] + textureLatWidth) {
+    if (longitudeCentre > textureOffset[0] + textureLongWidth ||
+        latitudeCentre > textureOffset[1] + textureLatWidth) {
         return false;
     }
 
     return true;
 }
 
-void Tile::addResources(const std::shared_ptr<TileResources> &resources, int level) {
-    // Assumes resources are added from coarse to fine for simplicity.
-    // Check it is true.
-    assert(level > lastLevel);
-    if (!isTileWithinTexture(resources->getTexture(TextureType::Day))) {
+void Tile::setResources(const std::shared_ptr<TileResources> &tileResources) {
+    if (!isTileWithinTexture(tileResources->getTexture(TextureType::Day))) {
         throw std::runtime_error("The tile is located outside of the resources definition.");
     }
-
-    lastLevel = level;
-
-    // Cross-reference resources of neighboring LODs
-    if (!lodResources.empty()) {
-        auto lastResources = lodResources.back();
-        assert(lastResources->getMesh().size() > resources->getMesh().size());
-        resources->finerResources.push_back(lastResources);
-        lastResources->coarserResources = resources;
-    }
-    // Add resources to the current tile
-    lodResources.push_back(resources);
+    resources = tileResources;
 }
 
 
 [[nodiscard]] bool Tile::isInViewFrustum(const Frustum &frustum) const {
+    // Bounding-sphere pre-test decides most of the tiles
+    auto radius = static_cast<float>(boundingSphereRadius);
+    if (frustum.isSphereOutside(boundingSphereCentre, radius)) {
+        return false;
+    }
+    if (frustum.isSphereInside(boundingSphereCentre, radius)) {
+        return true;
+    }
 
     unsigned int cornersOutsideFrustum = 0;
     auto tileCorners = getGeocentricTileCorners();
@@ -115,6 +101,13 @@ void Tile::addResources(const std::shared_ptr<TileResources> &resources, int lev
         return true;
     }
 
+    // Coarse tiles may be seen only in their middle part
+    for (const auto &point: samplePoints) {
+        if (!frustum.isPointOutside(point)) {
+            return true;
+        }
+    }
+
     // Check for intersection between tile edges and frustum planes
     auto tileEdges = getEdges();
     for (const auto &edge: tileEdges) {
@@ -136,14 +129,16 @@ void Tile::addResources(const std::shared_ptr<TileResources> &resources, int lev
     return sum;
 }
 
-[[nodiscard]] bool Tile::isFacingCamera(const glm::vec3 &cameraPosition) const {
-    // Calculate the vector from the tile's center to the camera position.
-    glm::vec3 toCamera = cameraPosition - getGeocentricPosition();
+[[nodiscard]] bool Tile::isAboveHorizon(const EllipsoidalOccluder &occluder) const {
+    if (!hasOccludeePoint) {
+        return true;
+    }
+    return occluder.isScaledSpacePointVisible(occludeePoint);
+}
 
-    // Calculate the dot product between the normal and the vector to the camera.
-    float dotProduct = glm::dot(normal, toCamera);
-    // If the dot product is positive, the tile is facing the camera.
-    return dotProduct > 0.0;
+glm::vec3 Tile::computeGeocentricPoint(Ellipsoid &ellipsoid, double pointLongitude, double pointLatitude) const {
+    auto geodeticPoint = utils::convertToRads(glm::vec3(pointLongitude, pointLatitude, 0));
+    return ellipsoid.convertGeodeticToGeocentric(geodeticPoint);
 }
 
 /**
@@ -153,37 +148,102 @@ void Tile::addResources(const std::shared_ptr<TileResources> &resources, int lev
 void Tile::updateGeocentricPosition(Ellipsoid &ellipsoid) {
     double longitudeCentre = longitude + longitudeWidth / 2.0;
     double latitudeCentre = latitude + latitudeWidth / 2.0;
+    double longitudeEnd = longitude + longitudeWidth;
+    double latitudeEnd = latitude + latitudeWidth;
 
-    auto upperLeftCorner = utils::convertToRads(glm::vec3(longitude, latitude, 0));
-    auto upperRightCorner = utils::convertToRads(glm::vec3(longitude + longitudeWidth, latitude, 0));
-    auto lowerLeftCorner = utils::convertToRads(glm::vec3(longitude, latitude + latitudeWidth, 0));
-    auto lowerRightCorner = utils::convertToRads(glm::vec3(longitude + longitudeWidth, latitude + latitudeWidth, 0));
-
-    auto geocentricUpperLeftCorner = ellipsoid.convertGeodeticToGeocentric(upperLeftCorner);
-    auto geocentricUpperRightCorner = ellipsoid.convertGeodeticToGeocentric(upperRightCorner);
-    auto geocentricLowerLeftCorner = ellipsoid.convertGeodeticToGeocentric(lowerLeftCorner);
-    auto geocentricLowerRightCorner = ellipsoid.convertGeodeticToGeocentric(lowerRightCorner);
+    auto geocentricUpperLeftCorner = computeGeocentricPoint(ellipsoid, longitude, latitude);
+    auto geocentricUpperRightCorner = computeGeocentricPoint(ellipsoid, longitudeEnd, latitude);
+    auto geocentricLowerLeftCorner = computeGeocentricPoint(ellipsoid, longitude, latitudeEnd);
+    auto geocentricLowerRightCorner = computeGeocentricPoint(ellipsoid, longitudeEnd, latitudeEnd);
     corners = std::array<glm::vec3, 4>({
                                                geocentricUpperLeftCorner, geocentricUpperRightCorner,
                                                geocentricLowerLeftCorner, geocentricLowerRightCorner
                                        });
-    tileWidth = glm::length(geocentricUpperRightCorner - geocentricUpperLeftCorner);
+    edgeCentres = std::array<glm::vec3, 4>({
+                                                   computeGeocentricPoint(ellipsoid, longitudeCentre, latitude),
+                                                   computeGeocentricPoint(ellipsoid, longitudeEnd, latitudeCentre),
+                                                   computeGeocentricPoint(ellipsoid, longitudeCentre, latitudeEnd),
+                                                   computeGeocentricPoint(ellipsoid, longitude, latitudeCentre)
+                                           });
 
     auto tileCentre = utils::convertToRads(glm::vec3(longitudeCentre, latitudeCentre, 0));
     geocentricPosition = ellipsoid.convertGeodeticToGeocentric(tileCentre);
-
     normal = ellipsoid.convertGeographicToGeodeticSurfaceNormal(tileCentre);
+
+    // The longest of the edges, measured along the surface. The edge at a pole collapses into a point.
+    double upperEdgeLength = glm::length(edgeCentres[0] - corners[0]) + glm::length(corners[1] - edgeCentres[0]);
+    double lowerEdgeLength = glm::length(edgeCentres[2] - corners[2]) + glm::length(corners[3] - edgeCentres[2]);
+    double sideEdgeLength = glm::length(edgeCentres[3] - corners[0]) + glm::length(corners[2] - edgeCentres[3]);
+    tileWidth = std::max(std::max(upperEdgeLength, lowerEdgeLength), sideEdgeLength);
+
+    for (int i = 0; i < 4; i++) {
+        samplePoints[i] = corners[i];
+        samplePoints[4 + i] = edgeCentres[i];
+    }
+    samplePoints[8] = geocentricPosition;
+    updateBounds(ellipsoid);
+}
+
+void Tile::setMaxHeightDisplacement(Ellipsoid &ellipsoid, double displacement) {
+    maxHeightDisplacement = displacement;
+    updateBounds(ellipsoid);
+}
+
+/**
+ * Computes the bounding volumes of the tile from its sample points, raised by the terrain.
+ */
+void Tile::updateBounds(Ellipsoid &ellipsoid) {
+    // The sample points form a 3x3 grid. The surface of each of its cells bulges
+    // above the cell at most by the sagitta of the cell's diagonal arc.
+    // Corners are ordered as upper left, upper right, lower left, lower right.
+    auto cornerNormal = [&ellipsoid, this](int corner) {
+        return ellipsoid.convertGeocentricToGeocentricSurfaceNormal(corners[corner]);
+    };
+    double firstDiagonal = glm::dot(cornerNormal(0), cornerNormal(3));
+    double secondDiagonal = glm::dot(cornerNormal(1), cornerNormal(2));
+    double diagonalAngle = std::acos(std::clamp(std::min(firstDiagonal, secondDiagonal), -1.0, 1.0));
+
+    double maxRadius = 0;
+    glm::vec3 centroid(0, 0, 0);
+    for (const auto &point: samplePoints) {
+        maxRadius = std::max(maxRadius, static_cast<double>(glm::length(point)));
+        centroid += point;
+    }
+    // The cell's diagonal is half of the tile's diagonal. The terrain moves the surface
+    // away from the centre, at most by the displacement of the farthest point.
+    surfaceDeviation = maxRadius * (1.0 - std::cos(diagonalAngle / 4.0) + maxHeightDisplacement);
+
+    boundingSphereCentre = centroid / static_cast<float>(samplePoints.size());
+    double maxDistance = 0;
+    for (const auto &point: samplePoints) {
+        maxDistance = std::max(maxDistance, static_cast<double>(glm::length(point - boundingSphereCentre)));
+    }
+    boundingSphereRadius = maxDistance + surfaceDeviation;
+
+    // The highest terrain is the last to sink below the horizon
+    std::array<glm::vec3, 9> raisedPoints;
+    for (size_t i = 0; i < samplePoints.size(); i++) {
+        raisedPoints[i] = samplePoints[i] * static_cast<float>(1.0 + maxHeightDisplacement);
+    }
+    hasOccludeePoint = EllipsoidalOccluder::computeOccludeePoint(
+            ellipsoid, geocentricPosition, raisedPoints.data(), static_cast<int>(raisedPoints.size()),
+            occludeePoint);
 }
 
 [[nodiscard]] std::array<glm::vec3, 4> Tile::getGeocentricTileCorners() const {
     return corners;
 }
 
-[[nodiscard]] std::array<std::pair<glm::vec3, glm::vec3>, 4> Tile::getEdges() const {
+[[nodiscard]] std::array<std::pair<glm::vec3, glm::vec3>, 8> Tile::getEdges() const {
+    // Corners are ordered as upper left, upper right, lower left, lower right.
     return {
-            std::pair(corners[0], corners[1]),
-            std::pair(corners[1], corners[2]),
-            std::pair(corners[2], corners[3]),
-            std::pair(corners[3], corners[0])
+            std::pair(corners[0], edgeCentres[0]),
+            std::pair(edgeCentres[0], corners[1]),
+            std::pair(corners[1], edgeCentres[1]),
+            std::pair(edgeCentres[1], corners[3]),
+            std::pair(corners[3], edgeCentres[2]),
+            std::pair(edgeCentres[2], corners[2]),
+            std::pair(corners[2], edgeCentres[3]),
+            std::pair(edgeCentres[3], corners[0])
     };
-}
\ No newline at end of file
+}
@@ -17,20 +17,44 @@
 #include "../textures/Texture.h"
 #include "../cameras/Camera.h"
 #include "../Frustum.h"
+#include "../culling/EllipsoidalOccluder.h"
 
 class TileResources;
 
 class Tile {
 private:
-    std::vector<std::shared_ptr<TileResources>> lodResources;
+    std::shared_ptr<TileResources> resources;
     double latitude, longitude, latitudeWidth, longitudeWidth;
+    // Level of detail in the texture atlases this tile belongs to.
+    int level;
+    // Children are stored next to each other in the tile container.
+    unsigned int firstChildIndex = 0;
+    unsigned int numChildren = 0;
     glm::vec3 geocentricPosition;
     std::array<glm::vec3, 4> corners;
+    // Points on the boundary of the tile, which together with the corners
+    // and the centre approximate the (possibly large) curved surface of the tile.
+    std::array<glm::vec3, 4> edgeCentres;
+    std::array<glm::vec3, 9> samplePoints;
+    // Maximum distance of the curved surface from the polyhedron spanned by the sample points.
+    double surfaceDeviation = 0;
+    // How far the terrain may raise the surface, relative to its distance from the centre.
+    double maxHeightDisplacement = 0;
+    glm::vec3 boundingSphereCentre;
+    double boundingSphereRadius = 0;
+    // Scaled-space point used for horizon culling. Tiles spanning more than
+    // a hemisphere have none and are never below the horizon.
+    glm::vec3 occludeePoint;
+    bool hasOccludeePoint = false;
     // Normal of the face of the tile.
     glm::vec3 normal;
     double tileWidth;
 
-    int lastLevel = -1;
+    /**
+     * The maximum allowed screen-space error (in pixels) before the tile
+     * is replaced by its children.
+     */
+    static constexpr double maxScreenSpaceError = 16.0;
 
     /**
      * Compute the screen-space error based on the given parameters.
@@ -43,7 +67,7 @@ private:
      * @return The calculated screen-space error.
      */
     double computeScreenSpaceError(double screenSpaceWidth, double distanceToCamera,
-                                   double cameraViewAngle, double geometricError) {
+                                   double cameraViewAngle, double geometricError) const {
         double viewFrustrumWidth = 2 * distanceToCamera * std::tan(cameraViewAngle / 2.0);
         double screenSpaceError = screenSpaceWidth * geometricError / viewFrustrumWidth;
         return screenSpaceError;
@@ -51,39 +75,66 @@ private:
 
     [[nodiscard]] double getViewingAngle(const Camera &camera) const;
 
+    [[nodiscard]] glm::vec3 computeGeocentricPoint(Ellipsoid &ellipsoid, double longitude, double latitude) const;
+
+    void updateBounds(Ellipsoid &ellipsoid);
+
 public:
-    explicit Tile(double latitude, double longitude, double latitudeWidth, double longitudeWidth)
+    explicit Tile(double latitude, double longitude, double latitudeWidth, double longitudeWidth,
+                  int level = 0)
             : latitude(latitude), longitude(longitude),
               latitudeWidth(latitudeWidth), longitudeWidth(longitudeWidth),
-              geocentricPosition(glm::vec3(0, 0, 0)) {
+              level(level), geocentricPosition(glm::vec3(0, 0, 0)) {
     }
 
     /**
-     * Selects the tile resources for the appropriate level of detail.
-     *
-     * We can use these quantities to compute the screen-space error and choose the LOD
-     * with the highest allowed screen-space error.
+     * Decides whether the tile is too coarse for the current view and
+     * should be replaced by its children.
      *
      * As the user zooms in, the screen space error becomes larger for all LODs.
-     * Thresholding at a certain value does the trick. We start at the lower resolution
-     * and increase the resolution until we get below a certain error.
+     * Thresholding at a certain value does the trick. The quadtree is traversed
+     * from the coarsest tiles, which are refined until the error gets below
+     * a certain threshold.
      *
      * The following parameters play a role in which LOD gets selected:
      * - the width of the screen-space (x)
-     * - distance from the center of the tile to the camera position (d)
+     * - distance from the closest point of the tile to the camera position (d)
      * - view angle of the camera (theta)
+     * - the spacing between vertices of the tile's mesh (e)
      */
-    std::shared_ptr<TileResources> getResources(
-            double screenSpaceWidth, double distanceToCamera, const Camera &camera);
+    [[nodiscard]] bool isRefinementNeeded(double screenSpaceWidth, const Camera &camera) const;
 
-    std::shared_ptr<TileResources> getResourcesByLevel(int level);
+    [[nodiscard]] const std::shared_ptr<TileResources> &getResources() const {
+        return resources;
+    }
 
     /**
      * Check the coords of this tile are within the coords of the resources.
      */
     [[nodiscard]] bool isTileWithinTexture(const std::shared_ptr<Texture> &texture) const ;
 
-    void addResources(const std::shared_ptr<TileResources> &resources, int level);
+    void setResources(const std::shared_ptr<TileResources> &tileResources);
+
+    void setChildren(unsigned int firstChild, unsigned int childrenCount) {
+        firstChildIndex = firstChild;
+        numChildren = childrenCount;
+    }
+
+    [[nodiscard]] bool hasChildren() const {
+        return numChildren > 0;
+    }
+
+    [[nodiscard]] unsigned int getFirstChildIndex() const {
+        return firstChildIndex;
+    }
+
+    [[nodiscard]] unsigned int getNumChildren() const {
+        return numChildren;
+    }
+
+    [[nodiscard]] int getLevel() const {
+        return level;
+    }
 
     /**
      * From: Geometric Approach - Testing Points and Spheres
@@ -96,7 +147,11 @@ public:
 
     [[nodiscard]] unsigned char sumOfBits(unsigned char var) const;
 
-    [[nodiscard]] bool isFacingCamera(const glm::vec3 &cameraPosition) const;
+    /**
+     * Checks whether any part of the tile can be above the horizon
+     * as seen from the camera of the occluder.
+     */
+    [[nodiscard]] bool isAboveHorizon(const EllipsoidalOccluder &occluder) const;
 
     /**
      * Uses longitude and latitude to project the centre of the tile
@@ -104,13 +159,53 @@ public:
      */
     void updateGeocentricPosition(Ellipsoid &ellipsoid);
 
+    /**
+     * Enlarges the bounds of the tile so that they contain the surface raised by the terrain,
+     * which scales the points of the surface by at most 1 + displacement.
+     */
+    void setMaxHeightDisplacement(Ellipsoid &ellipsoid, double displacement);
+
     [[nodiscard]] std::array<glm::vec3, 4> getGeocentricTileCorners() const;
 
-    [[nodiscard]] std::array<std::pair<glm::vec3, glm::vec3>, 4> getEdges() const;
+    /**
+     * The corners, the centres of the edges, and the centre of the tile.
+     */
+    [[nodiscard]] const std::array<glm::vec3, 9> &getSamplePoints() const {
+        return samplePoints;
+    }
+
+    [[nodiscard]] double getSurfaceDeviation() const {
+        return surfaceDeviation;
+    }
 
+    /**
+     * Returns the boundary of the tile as a closed polyline going through
+     * the corners and the centres of the edges.
+     */
+    [[nodiscard]] std::array<std::pair<glm::vec3, glm::vec3>, 8> getEdges() const;
 
+    /**
+     * Distance from the camera to the closest sampled point of the tile.
+     * For coarse tiles covering a large part of the globe, the distance to the
+     * centre would greatly overestimate how far the tile is.
+     */
+    [[nodiscard]] double getDistanceToCamera(const glm::vec3 &cameraPosition) const;
+
+    /**
+     * The spacing between neighbouring vertices of the tile's mesh.
+     */
+    [[nodiscard]] double getGeometricError() const;
+
+
+    /**
+     * The radius of a sphere enclosing the whole surface of the tile.
+     */
     [[nodiscard]] double getTileRadius() const {
-        return tileWidth / 2.0;
+        return boundingSphereRadius;
+    }
+
+    [[nodiscard]] glm::vec3 getBoundingSphereCentre() const {
+        return boundingSphereCentre;
     }
 
     [[nodiscard]] glm::vec3 getGeocentricPosition() const {
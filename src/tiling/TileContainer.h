@@ -9,58 +9,79 @@
 #include <vector>
 #include <string>
 #include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
 #include "../tiling/TileResources.h"
 #include "../textures/Texture.h"
 #include "../textures/TextureAtlas.h"
 #include "../tesselation/TileMeshTesselator.h"
 #include "../vertex.h"
+#include "TileMesh.h"
+#include "../culling/TileBounds.h"
 
 
 // Define the TileContainer class.
 
 class TileContainer {
 private:
+    // Tiles of all levels of detail forming a quadtree. The root tiles come first.
+    // The children of each tile are stored next to each other.
     std::vector<Tile> tiles;
+    unsigned int numRootTiles = 0;
     TileMeshTesselator &tileMeshTesselator;
     TextureAtlas &dayMapAtlas;
     TextureAtlas &nightMapAtlas;
     TextureAtlas &heightMapAtlas;
     Ellipsoid &ellipsoid;
-    std::vector<Mesh_t> cachedMeshes;
+    // Meshes indexed by the level of detail. All tiles of a level share the same mesh.
+    std::vector<TileMeshHandle> cachedMeshes;
+    // Sample points of the tiles in a layout suitable for batched culling.
+    TileBounds tileBounds;
 
     /**
     * Assigns the corresponding resources from texture atlases to
-    * the given tile. Generates meshes for all supported levels of detail.
+    * the given tile. Generates the mesh for the tile's level of detail
+    * if it has not been generated yet.
     */
     void setupTile(Tile &tile) {
-        int numLevels = heightMapAtlas.getNumLevelsOfDetail();
-
-        for (int level = 0; level < numLevels; ++level) {
-            // Based on the information of the tile and the current level,
-            // the texture atlas returns the correct texture
-            auto heightMap = heightMapAtlas.getTexture(level, tile);
-            auto nightMap = nightMapAtlas.getTexture(level, tile);
-            auto dayMap = dayMapAtlas.getTexture(level, tile);
-
-            if (level >= cachedMeshes.size()) {
-                // The heightMap determines the resolution of the mesh.
-                // Altough, the resolution of each heightmap image is the same,
-                // the area it covers differs. Thus, the resolution of the
-                // resulting mesh will also differ.
-                Resolution meshResolution = determineMeshResolution(heightMap, tile);
-                std::cout << meshResolution.getWidth() << ", " << meshResolution.getHeight() << std::endl;
-                // The ellipsoid is used to project the mesh onto it.
-                // The tile determines the position of the mesh on the ellipsoid.
-                Mesh_t mesh = tileMeshTesselator.generate(meshResolution, tile);
-
-                std::cout << "Mesh size (triangles): " << mesh.size() / 3 << std::endl;
-                cachedMeshes.push_back(mesh);
-            }
+        int level = tile.getLevel();
+
+        // Based on the information of the tile and its level,
+        // the texture atlas returns the correct texture
+        auto heightMap = heightMapAtlas.getTexture(level, tile);
+        auto nightMap = nightMapAtlas.getTexture(level, tile);
+        auto dayMap = dayMapAtlas.getTexture(level, tile);
 
-            Mesh_t mesh = cachedMeshes[level];
-            auto tileResource = std::make_shared<TileResources>(mesh, dayMap, nightMap, heightMap);
+        if (cachedMeshes[level] == nullptr) {
+            // The heightMap determines the resolution of the mesh.
+            // Each tile covers exactly one heightmap image. Since the resolution
+            // of each heightmap image is the same, the resolution of the mesh
+            // is the same for all levels, although the area it covers differs.
+            Resolution meshResolution = determineMeshResolution(heightMap, tile);
+            std::cout << meshResolution.getWidth() << ", " << meshResolution.getHeight() << std::endl;
+            // The tile determines the position of the mesh on the ellipsoid.
+            IndexedMesh mesh = tileMeshTesselator.generate(meshResolution, tile);
 
-            tile.addResources(tileResource, level);
+            std::cout << "Mesh size (triangles): " << mesh.getNumTriangles() << std::endl;
+            cachedMeshes[level] = std::make_shared<const TileMesh>(std::move(mesh), meshResolution);
+        }
+
+        auto tileResource = std::make_shared<TileResources>(cachedMeshes[level], dayMap, nightMap, heightMap);
+
+        tile.setResources(tileResource);
+    }
+
+    /**
+     * Cross-references resources of a tile and its children so that textures
+     * of the neighbouring levels of detail can be used while loading.
+     */
+    void linkResourcesWithChildren(Tile &tile) {
+        auto resources = tile.getResources();
+        for (unsigned int i = 0; i < tile.getNumChildren(); i++) {
+            auto childResources = tiles[tile.getFirstChildIndex() + i].getResources();
+            resources->finerResources.push_back(childResources);
+            childResources->coarserResources = resources;
         }
     }
 
@@ -97,28 +118,96 @@ private:
     }
 
     /**
-     * Implement globe division into tiles based on the most detailed resolution.
-     * The resolution determines how many tiles there will be per longitude and latitude.
-     * Even the coarse levels of detail will be composed of the same number of tiles. They
-     * will be simply composed of a smaller number of triangles and show a different texture.
+     * Returns the levels of detail ordered from the coarsest
+     * (the fewest tiles) to the finest one.
+     */
+    std::vector<int> getLevelsFromCoarsestToFinest() {
+        std::vector<int> levels(heightMapAtlas.getNumLevelsOfDetail());
+        for (int level = 0; level < levels.size(); level++) {
+            levels[level] = level;
+        }
+        std::sort(levels.begin(), levels.end(), [this](int first, int second) {
+            return heightMapAtlas.getLevelDimensions(first).getWidth() <
+                   heightMapAtlas.getLevelDimensions(second).getWidth();
+        });
+        return levels;
+    }
+
+    /**
+     * Divides the globe into a quadtree of tiles. Each tile covers exactly one texture
+     * of its level of detail. The coarsest level forms the roots (e.g., 2x1 tiles), and each
+     * finer level subdivides the tiles of the previous one (typically into 2x2 children).
      *
-     * @param numTilesLongitude Total tiles along the longitude (360 degrees)
-     * @param numTilesLatitude Total tiles along the latitude (180 degrees)
+     * @param levels Levels of detail ordered from the coarsest to the finest.
      */
-    void divideGlobeIntoTiles(int numTilesLongitude, int numTilesLatitude) {
-        // Calculate the width and height of each tile in degrees.
-        double tileWidth = 360.0 / numTilesLongitude;
-        double tileHeight = 180.0 / numTilesLatitude;
+    void divideGlobeIntoTiles(const std::vector<int> &levels) {
+        size_t numTiles = 0;
+        for (int level: levels) {
+            Resolution dimensions = heightMapAtlas.getLevelDimensions(level);
+            numTiles += dimensions.getWidth() * dimensions.getHeight();
+        }
+        // The tiles must not be reallocated as the children are added.
+        tiles.reserve(numTiles);
+
+        Resolution rootDimensions = heightMapAtlas.getLevelDimensions(levels[0]);
+        for (int latIndex = 0; latIndex < rootDimensions.getHeight(); ++latIndex) {
+            for (int lonIndex = 0; lonIndex < rootDimensions.getWidth(); ++lonIndex) {
+                tiles.push_back(createTile(lonIndex, latIndex, rootDimensions, levels[0]));
+            }
+        }
+        numRootTiles = tiles.size();
 
-        for (int latIndex = 0; latIndex < numTilesLatitude; ++latIndex) {
-            for (int lonIndex = 0; lonIndex < numTilesLongitude; ++lonIndex) {
-                double latitude = latIndex * tileHeight - 90.0;
-                double longitude = lonIndex * tileWidth - 180.0;
+        size_t parentsBegin = 0;
+        size_t parentsEnd = tiles.size();
+        for (int depth = 1; depth < levels.size(); depth++) {
+            Resolution parentDimensions = heightMapAtlas.getLevelDimensions(levels[depth - 1]);
+            Resolution dimensions = heightMapAtlas.getLevelDimensions(levels[depth]);
+            if (dimensions.getWidth() % parentDimensions.getWidth() != 0 ||
+                dimensions.getHeight() % parentDimensions.getHeight() != 0) {
+                throw std::runtime_error("The levels of detail of the texture atlas do not form a quadtree.");
+            }
 
-                Tile tile(latitude, longitude, tileHeight, tileWidth);
-                tiles.push_back(tile);
+            for (size_t parentIndex = parentsBegin; parentIndex < parentsEnd; parentIndex++) {
+                subdivideTile(parentIndex, parentDimensions, dimensions, levels[depth]);
             }
+            parentsBegin = parentsEnd;
+            parentsEnd = tiles.size();
         }
+        assert(tiles.size() == numTiles);
+    }
+
+    /**
+     * Appends the children of the given tile, which are of the next finer level.
+     */
+    void subdivideTile(size_t parentIndex, const Resolution &parentDimensions,
+                       const Resolution &dimensions, int level) {
+        int childrenLongitude = dimensions.getWidth() / parentDimensions.getWidth();
+        int childrenLatitude = dimensions.getHeight() / parentDimensions.getHeight();
+
+        // Compute the index of the parent within its level from its position
+        Tile &parent = tiles[parentIndex];
+        int parentLonIndex = static_cast<int>(std::lround(
+                (parent.getLongitude() + 180.0) / parent.getLongitudeWidth()));
+        int parentLatIndex = static_cast<int>(std::lround(
+                (parent.getLatitude() + 90.0) / parent.getLatitudeWidth()));
+        parent.setChildren(tiles.size(), childrenLongitude * childrenLatitude);
+
+        for (int latOffset = 0; latOffset < childrenLatitude; ++latOffset) {
+            for (int lonOffset = 0; lonOffset < childrenLongitude; ++lonOffset) {
+                int lonIndex = parentLonIndex * childrenLongitude + lonOffset;
+                int latIndex = parentLatIndex * childrenLatitude + latOffset;
+                tiles.push_back(createTile(lonIndex, latIndex, dimensions, level));
+            }
+        }
+    }
+
+    static Tile createTile(int lonIndex, int latIndex, const Resolution &dimensions, int level) {
+        // Calculate the width and height of each tile in degrees.
+        double tileWidth = 360.0 / dimensions.getWidth();
+        double tileHeight = 180.0 / dimensions.getHeight();
+        double latitude = latIndex * tileHeight - 90.0;
+        double longitude = lonIndex * tileWidth - 180.0;
+        return Tile(latitude, longitude, tileHeight, tileWidth, level);
     }
 
 public:
@@ -138,26 +227,77 @@ public:
     /**
     * Initializes the resources needed for rendering. Texture atlases are
     * used to load the textures at the various available levels of detail,
-    * and divides the globe into tiles based on the most detailed level of detail.
+    * and the globe is divided into a quadtree of tiles, one tile per texture.
     */
     void setupTiles() {
         assert(dayMapAtlas.getNumLevelsOfDetail() > 0);
         assert(heightMapAtlas.getNumLevelsOfDetail() > 0);
         assert(dayMapAtlas.getNumLevelsOfDetail() == heightMapAtlas.getNumLevelsOfDetail());
 
-        // Needs to know the finest heightMap resolution
-        Resolution dimensions = heightMapAtlas.getMostDetailedLevelDimensions();
-        this->divideGlobeIntoTiles(dimensions.getWidth(), dimensions.getHeight());
+        std::vector<int> levels = getLevelsFromCoarsestToFinest();
+        this->divideGlobeIntoTiles(levels);
 
+        cachedMeshes.resize(getNumLevels());
         for (Tile &tile: tiles) {
             setupTile(tile);
         }
+        for (Tile &tile: tiles) {
+            linkResourcesWithChildren(tile);
+        }
+    }
+
+    /**
+     * Projects all tiles onto the surface of the given ellipsoid
+     * and updates their bounds used for culling.
+     */
+    void updateGeocentricPositions(Ellipsoid &targetEllipsoid) {
+        for (Tile &tile: tiles) {
+            tile.updateGeocentricPosition(targetEllipsoid);
+        }
+        tileBounds.build(tiles);
+    }
+
+    /**
+     * Updates the bounds of all tiles for the terrain raising the surface,
+     * see Tile::setMaxHeightDisplacement.
+     */
+    void updateMaxHeightDisplacement(Ellipsoid &targetEllipsoid, double displacement) {
+        for (Tile &tile: tiles) {
+            tile.setMaxHeightDisplacement(targetEllipsoid, displacement);
+        }
+        tileBounds.build(tiles);
     }
 
+    [[nodiscard]] const TileBounds &getTileBounds() const {
+        return tileBounds;
+    }
+
+    /**
+     * Returns the tiles of all levels of detail.
+     */
     std::vector<Tile> &getTiles() {
         return tiles;
     }
 
+    Tile &getTile(unsigned int index) {
+        return tiles[index];
+    }
+
+    [[nodiscard]] const Tile &getTile(unsigned int index) const {
+        return tiles[index];
+    }
+
+    /**
+     * The root tiles are stored at the beginning of the tiles.
+     */
+    [[nodiscard]] unsigned int getNumRootTiles() const {
+        return numRootTiles;
+    }
+
+    [[nodiscard]] const TileMesh &getMesh(int level) const {
+        return *cachedMeshes[level];
+    }
+
     int getNumLevels() const {
         return dayMapAtlas.getNumLevelsOfDetail();
     }
@@ -0,0 +1,61 @@
+#ifndef EARTH_VISUALIZATION_TILEMESH_H
+#define EARTH_VISUALIZATION_TILEMESH_H
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include "Resolution.h"
+#include "../vertex.h"
+
+/**
+ * The mesh shared by all tiles of a level of detail.
+ *
+ * The mesh is immutable once generated. Tiles refer to it through a shared handle,
+ * so the geometry is stored only once per level, and the metadata needed every
+ * frame is computed in advance.
+ */
+class TileMesh {
+private:
+    IndexedMesh mesh;
+    Resolution resolution;
+    // The spacing between neighbouring vertices relative to the width of the tile
+    double relativeGeometricError;
+
+public:
+    explicit TileMesh(IndexedMesh mesh, Resolution resolution)
+            : mesh(std::move(mesh)), resolution(resolution) {
+        // The mesh is a regular grid of quads, each made up of two triangles.
+        double numQuadsAcross = std::max(std::sqrt(static_cast<double>(getNumTriangles()) / 2.0), 1.0);
+        relativeGeometricError = 1.0 / numQuadsAcross;
+    }
+
+    [[nodiscard]] const IndexedMesh &getIndexedMesh() const {
+        return mesh;
+    }
+
+    [[nodiscard]] size_t getNumVertices() const {
+        return mesh.vertices.size();
+    }
+
+    [[nodiscard]] size_t getNumTriangles() const {
+        return mesh.getNumTriangles();
+    }
+
+    /**
+     * The number of quads of the grid in longitude and latitude.
+     */
+    [[nodiscard]] Resolution getResolution() const {
+        return resolution;
+    }
+
+    /**
+     * The spacing between neighbouring vertices as a fraction of the tile width.
+     */
+    [[nodiscard]] double getRelativeGeometricError() const {
+        return relativeGeometricError;
+    }
+};
+
+typedef std::shared_ptr<const TileMesh> TileMeshHandle;
+
+#endif //EARTH_VISUALIZATION_TILEMESH_H
@@ -8,10 +8,12 @@
 #include "../textures/Texture.h"
 #include "../vertex.h"
 #include "Tile.h"
+#include "TileMesh.h"
 #include <utility>
 #include <vector>
 #include <glm/vec3.hpp>
 #include <memory>
+#include <algorithm>
 
 enum TextureType {
     Day, Night, HeightMap
@@ -19,30 +21,29 @@ enum TextureType {
 
 class TileResources {
 private:
-    // Mesh covers always the tile only
-    Mesh_t mesh;
+    // Mesh covers always the tile only. It is shared by all tiles of the level.
+    TileMeshHandle mesh;
     // Textures may cover many tiles
     std::shared_ptr<Texture> dayTexture;
     std::shared_ptr<Texture> nightTexture;
     std::shared_ptr<Texture> heightMap;
 public:
-    unsigned int meshVAO = 0, meshVBO = 0;
     // Coarser and finer resources form a hierarchical structure of the resources.
     std::shared_ptr<TileResources> coarserResources;
     std::vector<std::shared_ptr<TileResources>> finerResources;
 
-    explicit TileResources(Mesh_t mesh, std::shared_ptr<Texture> dayTexture,
+    explicit TileResources(TileMeshHandle mesh, std::shared_ptr<Texture> dayTexture,
                            std::shared_ptr<Texture> nightTexture,
                            std::shared_ptr<Texture> heightMap) :
             mesh(std::move(mesh)), dayTexture(std::move(dayTexture)),
             nightTexture(std::move(nightTexture)), heightMap(std::move(heightMap)) {
     }
 
-    [[nodiscard]] Mesh_t getMesh() const {
-        return mesh;
+    [[nodiscard]] const TileMesh &getMesh() const {
+        return *mesh;
     }
 
-    [[nodiscard]] std::shared_ptr<Texture> getTexture(TextureType textureType) const {
+    [[nodiscard]] const std::shared_ptr<Texture> &getTexture(TextureType textureType) const {
         switch (textureType) {
             case TextureType::Day: {
                 return dayTexture;
@@ -58,6 +59,28 @@ public:
         }
     }
 
+    /**
+     * @return True if all textures of these resources are ready in OpenGL context.
+     */
+    [[nodiscard]] bool isPreparedInGlContext() const {
+        return dayTexture->isPreparedInGlContext() &&
+               nightTexture->isPreparedInGlContext() &&
+               heightMap->isPreparedInGlContext();
+    }
+
+    /**
+     * @return True if there are finer resources and all of them are ready in OpenGL context.
+     */
+    [[nodiscard]] bool areFinerResourcesPrepared() const {
+        if (finerResources.empty()) {
+            return false;
+        }
+        return std::all_of(finerResources.begin(), finerResources.end(),
+                           [](const std::shared_ptr<TileResources> &finer) {
+                               return finer->isPreparedInGlContext();
+                           });
+    }
+
     /**
      * @return True if a texture ready in OpenGL context was found.
      */
@@ -74,28 +97,6 @@ public:
         }
     }
 
-    [[nodiscard]] bool getFinerTexture(
-            const Tile &tile, std::shared_ptr<Texture> &texture, TextureType textureType) const {
-        if (finerResources.empty()) {
-            return false;
-        }
-        for (auto &finerResource: finerResources) {
-            // Skip if the overlap of the tile and the resources in none.
-            auto finerTexture = finerResource->getTexture(textureType);
-            if (!tile.isTileWithinTexture(finerTexture)) {
-                continue;
-            }
-
-            if (finerTexture->isPreparedInGlContext()) {
-                texture = finerTexture;
-                return true;
-            } else {
-                return finerResource->getFinerTexture(tile, texture, textureType);
-            }
-        }
-        return false;
-    }
-
 };
 
 
@@ -1,5 +1,7 @@
 
 #include "vertex.h"
+#include <algorithm>
+#include <cmath>
 
 typedef std::vector<glm::vec3> Mesh_t;
 
@@ -15,3 +17,21 @@ std::vector<t_vertex> convertToVertices(const std::vector<glm::vec3> &projectedV
     }
     return convertedVertices;
 }
+
+static unsigned short quantizeUnitInterval(float value) {
+    float clamped = std::min(std::max(value, 0.f), 1.f);
+    return static_cast<unsigned short>(std::lround(clamped * 65535.f));
+}
+
+std::vector<t_tile_vertex> convertToTileVertices(const std::vector<glm::vec3> &gridVertices) {
+    std::vector<t_tile_vertex> convertedVertices;
+    convertedVertices.reserve(gridVertices.size());
+    for (const auto &vec3: gridVertices) {
+        t_tile_vertex vertex;
+        vertex.longitude = quantizeUnitInterval(vec3.x);
+        vertex.latitude = quantizeUnitInterval(vec3.y);
+
+        convertedVertices.push_back(vertex);
+    }
+    return convertedVertices;
+}
@@ -9,8 +9,35 @@ typedef struct {
     float x, y, z;
 } t_vertex;
 
+/**
+ * A vertex of a tile grid. The offset within the tile in longitude and latitude
+ * in the [0, 1] range is quantized to 16 bits each and read normalized by the shader.
+ */
+typedef struct {
+    unsigned short longitude, latitude;
+} t_tile_vertex;
+
 typedef std::vector<glm::vec3> Mesh_t;
 
+/**
+ * A triangle mesh whose triangles share vertices.
+ * Each triple of indices defines a single triangle.
+ */
+struct IndexedMesh {
+    Mesh_t vertices;
+    std::vector<unsigned int> indices;
+
+    [[nodiscard]] size_t getNumTriangles() const {
+        return indices.size() / 3;
+    }
+};
+
 std::vector<t_vertex> convertToVertices(const std::vector<glm::vec3> &projectedVertices);
 
+/**
+ * Packs vertices of a tile grid. Only the x (longitude) and y (latitude)
+ * offsets within the tile are kept; the tile edges 0 and 1 are represented exactly.
+ */
+std::vector<t_tile_vertex> convertToTileVertices(const std::vector<glm::vec3> &gridVertices);
+
 #endif //EARTH_VISUALIZATION_VERTEX_H
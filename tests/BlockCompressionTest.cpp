@@ -0,0 +1,153 @@
+#include <vector>
+#include <cstdlib>
+#include <cstdint>
+#include "gtest/gtest.h"
+#include "../src/textures/BlockCompression.h"
+
+static uint64_t readBits(const unsigned char *block, int position, int numBits) {
+    uint64_t value = 0;
+    for (int bit = 0; bit < numBits; bit++, position++) {
+        value |= static_cast<uint64_t>((block[position / 8] >> (position % 8)) & 1) << bit;
+    }
+    return value;
+}
+
+static void decodeRgb565(uint64_t packed, int color[3]) {
+    int red = (packed >> 11) & 31, green = (packed >> 5) & 63, blue = packed & 31;
+    color[0] = (red << 3) | (red >> 2);
+    color[1] = (green << 2) | (green >> 4);
+    color[2] = (blue << 3) | (blue >> 2);
+}
+
+/**
+ * Decodes a block into 4x4 RGB pixels, following the specifications of the formats.
+ * Only mode 6 of BC7 is supported.
+ */
+static void decodeBlock(TextureCompression compression, const unsigned char *block, int pixels[16][3]) {
+    if (compression == TextureCompression::BC1) {
+        int palette[4][3];
+        decodeRgb565(readBits(block, 0, 16), palette[0]);
+        decodeRgb565(readBits(block, 16, 16), palette[1]);
+        bool isFourColors = readBits(block, 0, 16) > readBits(block, 16, 16);
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = isFourColors ? (2 * palette[0][c] + palette[1][c]) / 3
+                                         : (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = isFourColors ? (palette[0][c] + 2 * palette[1][c]) / 3 : 0;
+        }
+        for (int i = 0; i < 16; i++) {
+            int index = static_cast<int>(readBits(block, 32 + 2 * i, 2));
+            std::copy(palette[index], palette[index] + 3, pixels[i]);
+        }
+    } else if (compression == TextureCompression::BC4) {
+        int red0 = static_cast<int>(readBits(block, 0, 8));
+        int red1 = static_cast<int>(readBits(block, 8, 8));
+        int palette[8] = {red0, red1};
+        for (int i = 2; i < 8; i++) {
+            palette[i] = red0 > red1 ? ((8 - i) * red0 + (i - 1) * red1 + 3) / 7
+                                     : i < 6 ? ((6 - i) * red0 + (i - 1) * red1 + 2) / 5 : (i == 6 ? 0 : 255);
+        }
+        for (int i = 0; i < 16; i++) {
+            int value = palette[readBits(block, 16 + 3 * i, 3)];
+            pixels[i][0] = pixels[i][1] = pixels[i][2] = value;
+        }
+    } else {
+        const int weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+        ASSERT_EQ(readBits(block, 0, 7), 1u << 6);
+        int pBit0 = static_cast<int>(readBits(block, 63, 1));
+        int pBit1 = static_cast<int>(readBits(block, 64, 1));
+        ASSERT_EQ(readBits(block, 49, 7), 127u); // Opaque
+        for (int i = 0; i < 16; i++) {
+            int index = i == 0 ? static_cast<int>(readBits(block, 65, 3))
+                               : static_cast<int>(readBits(block, 68 + 4 * (i - 1), 4));
+            for (int c = 0; c < 3; c++) {
+                int value0 = static_cast<int>(readBits(block, 7 + 14 * c, 7) << 1) | pBit0;
+                int value1 = static_cast<int>(readBits(block, 14 + 14 * c, 7) << 1) | pBit1;
+                pixels[i][c] = ((64 - weights[index]) * value0 + weights[index] * value1 + 32) >> 6;
+            }
+        }
+    }
+}
+
+/**
+ * A smooth gradient with a little noise, like the tiles of the day maps.
+ */
+static std::vector<unsigned char> createImage(int width, int height, int channels) {
+    std::vector<unsigned char> image(static_cast<size_t>(width) * height * channels);
+    srand(7);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            for (int c = 0; c < channels; c++) {
+                int value = x * 160 / width + y * 64 / height + c * 10 + rand() % 5;
+                image[(static_cast<size_t>(y) * width + x) * channels + c] =
+                        static_cast<unsigned char>(std::min(value, 255));
+            }
+        }
+    }
+    return image;
+}
+
+/**
+ * Encodes and decodes the image, returning the largest error of any channel.
+ */
+static int getMaxError(TextureCompression compression, int width, int height, int channels) {
+    std::vector<unsigned char> image = createImage(width, height, channels);
+    std::vector<unsigned char> blocks(BlockCompression::getLevelSize(compression, width, height, channels, 0));
+    BlockCompression::encode(compression, image.data(), width, height, channels, blocks.data());
+
+    int blocksPerRow = (width + 3) / 4;
+    int maxError = 0;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            size_t blockIndex = static_cast<size_t>(y / 4) * blocksPerRow + x / 4;
+            int decoded[16][3];
+            decodeBlock(compression, blocks.data() + blockIndex * BlockCompression::getBlockSize(compression),
+                        decoded);
+            int numCompared = compression == TextureCompression::BC4 ? 1 : 3;
+            for (int c = 0; c < numCompared; c++) {
+                int original = image[(static_cast<size_t>(y) * width + x) * channels + c];
+                maxError = std::max(maxError, std::abs(decoded[(y % 4) * 4 + x % 4][c] - original));
+            }
+        }
+    }
+    return maxError;
+}
+
+TEST(BlockCompressionTest, EncodedImagesStayCloseToTheOriginal) {
+    EXPECT_LE(getMaxError(TextureCompression::BC1, 64, 32, 3), 16);
+    EXPECT_LE(getMaxError(TextureCompression::BC7, 64, 32, 3), 8);
+    EXPECT_LE(getMaxError(TextureCompression::BC4, 64, 32, 1), 4);
+    // Partial blocks at the edges
+    EXPECT_LE(getMaxError(TextureCompression::BC1, 15, 7, 4), 16);
+    EXPECT_LE(getMaxError(TextureCompression::BC4, 30, 5, 1), 4);
+}
+
+TEST(BlockCompressionTest, UniformBlocksAreExact) {
+    for (TextureCompression compression: {TextureCompression::BC4, TextureCompression::BC7}) {
+        int channels = compression == TextureCompression::BC4 ? 1 : 3;
+        std::vector<unsigned char> image(4 * 4 * channels, 201);
+        unsigned char block[16] = {};
+        BlockCompression::encode(compression, image.data(), 4, 4, channels, block);
+        int decoded[16][3];
+        decodeBlock(compression, block, decoded);
+        for (auto &pixel: decoded) {
+            EXPECT_EQ(pixel[0], 201);
+        }
+    }
+}
+
+TEST(BlockCompressionTest, ComputesTheSizesOfCompressedMipChains) {
+    // 8x8, 4x4, 2x2 and 1x1; the last two take a whole block
+    EXPECT_EQ(BlockCompression::getChainSize(TextureCompression::BC1, 8, 8, 3, 4), (4 + 1 + 1 + 1) * 8);
+    EXPECT_EQ(BlockCompression::getLevelOffset(TextureCompression::BC7, 8, 8, 3, 2), (4 + 1) * 16);
+    EXPECT_EQ(BlockCompression::getLevelSize(TextureCompression::None, 8, 8, 3, 1), 4 * 4 * 3);
+    // 480x480 tiles take 6x less memory in BC1 than in RGB8
+    EXPECT_EQ(BlockCompression::getLevelSize(TextureCompression::BC1, 480, 480, 3, 0) * 6,
+              BlockCompression::getLevelSize(TextureCompression::None, 480, 480, 3, 0));
+
+    EXPECT_FALSE(BlockCompression::isCompatible(TextureCompression::BC4, 3));
+    EXPECT_FALSE(BlockCompression::isCompatible(TextureCompression::BC1, 1));
+    TextureCompression compression;
+    ASSERT_TRUE(BlockCompression::parseCompression("bc7", compression));
+    EXPECT_EQ(compression, TextureCompression::BC7);
+    EXPECT_FALSE(BlockCompression::parseCompression("dxt5", compression));
+}
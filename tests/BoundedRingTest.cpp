@@ -0,0 +1,85 @@
+#include <vector>
+#include <thread>
+#include <memory>
+#include <atomic>
+#include "gtest/gtest.h"
+#include "../src/threading/BoundedRing.h"
+
+TEST(BoundedRingTest, KeepsTheOrderAndRejectsWhenFull) {
+    BoundedRing<int> ring(3);
+    ASSERT_EQ(ring.getCapacity(), 4);
+    EXPECT_TRUE(ring.isEmpty());
+
+    for (int value = 0; value < 4; value++) {
+        EXPECT_TRUE(ring.tryPush(value));
+    }
+    int rejected = 4;
+    EXPECT_FALSE(ring.tryPush(rejected));
+    EXPECT_EQ(rejected, 4);
+
+    int value;
+    for (int expected = 0; expected < 4; expected++) {
+        ASSERT_TRUE(ring.tryPop(value));
+        EXPECT_EQ(value, expected);
+        EXPECT_EQ(ring.isEmpty(), expected == 3);
+    }
+    EXPECT_FALSE(ring.tryPop(value));
+}
+
+TEST(BoundedRingTest, MovesMoveOnlyValues) {
+    BoundedRing<std::unique_ptr<int>> ring(2);
+    auto pointer = std::make_unique<int>(42);
+    ASSERT_TRUE(ring.tryPush(pointer));
+    EXPECT_EQ(pointer, nullptr);
+
+    auto full = std::make_unique<int>(1);
+    ASSERT_TRUE(ring.tryPush(full));
+    auto rejected = std::make_unique<int>(2);
+    EXPECT_FALSE(ring.tryPush(rejected));
+    EXPECT_NE(rejected, nullptr); // A value is moved only if it fits
+
+    std::unique_ptr<int> popped;
+    ASSERT_TRUE(ring.tryPop(popped));
+    EXPECT_EQ(*popped, 42);
+}
+
+TEST(BoundedRingTest, PassesAllValuesBetweenManyProducersAndConsumers) {
+    const int numProducers = 4;
+    const int numConsumers = 3;
+    const int valuesPerProducer = 20000;
+    BoundedRing<int> ring(64);
+
+    std::vector<std::atomic<int>> received(numProducers * valuesPerProducer);
+    std::atomic<int> numReceived{0};
+    std::vector<std::thread> threads;
+    for (int producer = 0; producer < numProducers; producer++) {
+        threads.emplace_back([&ring, producer] {
+            for (int i = 0; i < valuesPerProducer; i++) {
+                int value = producer * valuesPerProducer + i;
+                while (!ring.tryPush(value)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int consumer = 0; consumer < numConsumers; consumer++) {
+        threads.emplace_back([&] {
+            int value;
+            while (numReceived < numProducers * valuesPerProducer) {
+                if (ring.tryPop(value)) {
+                    received[value]++;
+                    numReceived++;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+
+    for (const auto &count: received) {
+        EXPECT_EQ(count, 1);
+    }
+}
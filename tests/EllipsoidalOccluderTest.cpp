@@ -0,0 +1,91 @@
+#include <vector>
+#include "gtest/gtest.h"
+#include "../src/culling/EllipsoidalOccluder.h"
+#include "../src/tiling/Tile.h"
+
+class EllipsoidalOccluderFixture : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        int numTilesLongitude = 128;
+        int numTilesLatitude = 64;
+        double tileWidth = 360.0 / numTilesLongitude;
+        double tileHeight = 180.0 / numTilesLatitude;
+        for (int latIndex = 0; latIndex < numTilesLatitude; latIndex++) {
+            for (int lonIndex = 0; lonIndex < numTilesLongitude; lonIndex++) {
+                tiles.emplace_back(latIndex * tileHeight - 90.0, lonIndex * tileWidth - 180.0, tileHeight, tileWidth);
+            }
+        }
+        for (Tile &tile: tiles) {
+            tile.updateGeocentricPosition(ellipsoid);
+        }
+    }
+
+    Ellipsoid ellipsoid = Ellipsoid::unitSphere();
+    std::vector<Tile> tiles;
+};
+
+TEST_F(EllipsoidalOccluderFixture, PointsInFrontOfHorizonAreVisible) {
+    EllipsoidalOccluder occluder(ellipsoid, glm::vec3(2, 0, 0));
+
+    EXPECT_TRUE(occluder.isScaledSpacePointVisible(glm::vec3(1, 0, 0)));
+    EXPECT_TRUE(occluder.isScaledSpacePointVisible(glm::vec3(0.6, 0.8, 0)));
+    EXPECT_FALSE(occluder.isScaledSpacePointVisible(glm::vec3(0, 1, 0)));
+    EXPECT_FALSE(occluder.isScaledSpacePointVisible(glm::vec3(-1, 0, 0)));
+    // Far above the surface, the point can be seen over the horizon
+    EXPECT_TRUE(occluder.isScaledSpacePointVisible(glm::vec3(-0.5, 10, 0)));
+}
+
+TEST_F(EllipsoidalOccluderFixture, CullsOnlyTilesBelowHorizon) {
+    // Low altitude above the surface
+    glm::vec3 cameraPosition = glm::normalize(glm::vec3(1, 0.3, 0.2)) * 1.01f;
+    EllipsoidalOccluder occluder(ellipsoid, cameraPosition);
+
+    int numCulled = 0;
+    for (const Tile &tile: tiles) {
+        if (tile.isAboveHorizon(occluder)) {
+            continue;
+        }
+        numCulled++;
+        // A point on the unit sphere is below the horizon if dot(point, camera) < 1
+        for (const auto &point: tile.getSamplePoints()) {
+            EXPECT_LT(glm::dot(point, cameraPosition), 1.0f);
+        }
+    }
+    // Most of the globe is below the horizon
+    EXPECT_GT(numCulled, tiles.size() * 9 / 10);
+}
+
+TEST_F(EllipsoidalOccluderFixture, LargeTilesHaveNoOccludeePoint) {
+    Tile hemisphere(-90, -180, 180, 180);
+    hemisphere.updateGeocentricPosition(ellipsoid);
+    EllipsoidalOccluder occluder(ellipsoid, glm::vec3(1.01, 0, 0));
+
+    EXPECT_TRUE(hemisphere.isAboveHorizon(occluder));
+}
+
+TEST_F(EllipsoidalOccluderFixture, RaisedTerrainIsNotCulled) {
+    glm::vec3 cameraPosition = glm::normalize(glm::vec3(1, 0.3, 0.2)) * 1.01f;
+    EllipsoidalOccluder occluder(ellipsoid, cameraPosition);
+    const float displacement = 0.04f;
+
+    int numCulledOnSurface = 0;
+    for (const Tile &tile: tiles) {
+        numCulledOnSurface += tile.isAboveHorizon(occluder) ? 0 : 1;
+    }
+
+    int numCulled = 0;
+    for (Tile &tile: tiles) {
+        tile.setMaxHeightDisplacement(ellipsoid, displacement);
+        if (tile.isAboveHorizon(occluder)) {
+            continue;
+        }
+        numCulled++;
+        // Even the highest terrain of a culled tile is hidden
+        for (const auto &point: tile.getSamplePoints()) {
+            EXPECT_FALSE(occluder.isScaledSpacePointVisible(point * (1 + displacement)));
+        }
+    }
+    // Mountains rise above the horizon
+    EXPECT_LT(numCulled, numCulledOnSurface);
+    EXPECT_GT(numCulled, 0);
+}
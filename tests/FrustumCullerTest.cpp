@@ -0,0 +1,106 @@
+#include <vector>
+#include <numeric>
+#include "gtest/gtest.h"
+#include "../src/culling/FrustumCuller.h"
+#include <glm/mat4x4.hpp> // glm::mat4
+#include <glm/gtc/matrix_transform.hpp>
+
+class FrustumCullerFixture : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        // The grid of the finest level of detail
+        int numTilesLongitude = 128;
+        int numTilesLatitude = 64;
+        double tileWidth = 360.0 / numTilesLongitude;
+        double tileHeight = 180.0 / numTilesLatitude;
+        for (int latIndex = 0; latIndex < numTilesLatitude; latIndex++) {
+            for (int lonIndex = 0; lonIndex < numTilesLongitude; lonIndex++) {
+                tiles.emplace_back(latIndex * tileHeight - 90.0, lonIndex * tileWidth - 180.0, tileHeight, tileWidth);
+            }
+        }
+        for (Tile &tile: tiles) {
+            tile.updateGeocentricPosition(ellipsoid);
+        }
+        bounds.build(tiles);
+
+        cameraPositions = {
+                glm::vec3(1.5, 0, 0),
+                glm::vec3(0, 1.5, 1.5),
+                glm::vec3(-1.05, 0.1, 0.2),
+                glm::vec3(0.3, -0.2, 1.01)
+        };
+    }
+
+    static Frustum createFrustum(const glm::vec3 &cameraPosition) {
+        glm::mat4 view = glm::lookAt(cameraPosition, glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.01f, 10.0f);
+        return Frustum(view, projection);
+    }
+
+    Ellipsoid ellipsoid = Ellipsoid::unitSphere();
+    std::vector<Tile> tiles;
+    TileBounds bounds;
+    std::vector<glm::vec3> cameraPositions;
+};
+
+TEST_F(FrustumCullerFixture, BatchedKernelsMatchScalarClassification) {
+    std::vector<unsigned int> tileIndices(tiles.size());
+    std::iota(tileIndices.begin(), tileIndices.end(), 0);
+    std::vector<uint8_t> indexedMask;
+    std::vector<uint8_t> rangeMask;
+
+    for (const auto &cameraPosition: cameraPositions) {
+        FrustumCuller culler(createFrustum(cameraPosition));
+        culler.cullTiles(bounds, tileIndices.data(), tileIndices.size(), indexedMask);
+        culler.cullTileRange(bounds, 0, tiles.size(), rangeMask);
+
+        for (unsigned int i = 0; i < tiles.size(); i++) {
+            bool expected = culler.isTileVisible(bounds, i);
+            ASSERT_EQ(FrustumCuller::isVisible(indexedMask, i), expected);
+            ASSERT_EQ(FrustumCuller::isVisible(rangeMask, i), expected);
+        }
+    }
+}
+
+TEST_F(FrustumCullerFixture, ClassifiesIncompleteBatches) {
+    FrustumCuller culler(createFrustum(cameraPositions[1]));
+    std::vector<unsigned int> tileIndices = {8000, 17, 4096, 5, 8191};
+    std::vector<uint8_t> mask;
+
+    culler.cullTiles(bounds, tileIndices.data(), tileIndices.size(), mask);
+    ASSERT_EQ(mask.size(), 1);
+    for (int i = 0; i < tileIndices.size(); i++) {
+        EXPECT_EQ(FrustumCuller::isVisible(mask, i), culler.isTileVisible(bounds, tileIndices[i]));
+    }
+    EXPECT_EQ(mask[0] >> tileIndices.size(), 0);
+
+    // The last tiles of the grid do not fill a whole batch
+    culler.cullTileRange(bounds, 8189, 3, mask);
+    ASSERT_EQ(mask.size(), 1);
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(FrustumCuller::isVisible(mask, i), culler.isTileVisible(bounds, 8189 + i));
+    }
+}
+
+TEST_F(FrustumCullerFixture, KeepsTilesWithPointsInsideFrustum) {
+    std::vector<uint8_t> mask;
+    for (const auto &cameraPosition: cameraPositions) {
+        Frustum frustum = createFrustum(cameraPosition);
+        FrustumCuller culler(frustum);
+        culler.cullTileRange(bounds, 0, tiles.size(), mask);
+
+        int numCulled = 0;
+        for (unsigned int i = 0; i < tiles.size(); i++) {
+            bool isAnyPointInside = false;
+            for (const auto &point: tiles[i].getSamplePoints()) {
+                isAnyPointInside |= !frustum.isPointOutside(point);
+            }
+            if (isAnyPointInside) {
+                EXPECT_TRUE(FrustumCuller::isVisible(mask, i));
+            }
+            numCulled += !FrustumCuller::isVisible(mask, i);
+        }
+        // The camera never sees the whole globe
+        EXPECT_GT(numCulled, 0);
+    }
+}
@@ -0,0 +1,42 @@
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+#include "gtest/gtest.h"
+#include "../src/textures/MipChain.h"
+
+TEST(MipChainTest, AveragesBlocksOfPixels) {
+    const unsigned char source[] = {
+            0, 4, 8, 9,
+            4, 8, 10, 11
+    };
+    unsigned char destination[2];
+    MipChain::downsample(source, 4, 2, 1, destination);
+    EXPECT_EQ(destination[0], 4);
+    EXPECT_EQ(destination[1], 10); // 9.5 is rounded up
+
+    EXPECT_EQ(MipChain::getNumLevels(480, 480), 9);
+    EXPECT_EQ(MipChain::getNumLevels(4, 1), 3);
+}
+
+TEST(MipChainTest, VectorizedDownsamplingMatchesTheScalarOne) {
+    srand(3);
+    // Odd and even sizes, with and without a remainder after the vectorized pixels
+    for (int width: {1, 7, 16, 33, 480}) {
+        for (int channels: {1, 3, 4}) {
+            int height = width / 2 + 1;
+            std::vector<unsigned char> source(static_cast<size_t>(width) * height * channels);
+            for (unsigned char &value: source) {
+                value = static_cast<unsigned char>(rand() % 256);
+            }
+            size_t size = MipChain::getLevelSize(width, height, channels, 1);
+            std::vector<unsigned char> vectorized(size + 4, 0xAB), scalar(size);
+            MipChain::downsample(source.data(), width, height, channels, vectorized.data());
+            MipChain::downsampleScalar(source.data(), width, height, channels, scalar.data());
+
+            ASSERT_TRUE(std::equal(scalar.begin(), scalar.end(), vectorized.begin()))
+                                        << width << "x" << height << "x" << channels;
+            // Nothing is written past the level
+            EXPECT_EQ(vectorized[size], 0xAB);
+        }
+    }
+}
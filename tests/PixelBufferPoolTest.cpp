@@ -0,0 +1,63 @@
+#include <cstring>
+#include "gtest/gtest.h"
+#include "../src/textures/PixelBufferPool.h"
+
+static const size_t tileSize = 480 * 480 * 3;
+
+TEST(PixelBufferPoolTest, ReusesRecycledTileBuffers) {
+    PixelBufferPool pool;
+    void *first = pool.allocate(tileSize);
+    pool.recycle(first);
+
+    void *second = pool.allocate(tileSize);
+    EXPECT_EQ(second, first);
+    PixelBufferPoolStatistics statistics = pool.getStatistics();
+    EXPECT_EQ(statistics.hits, 1);
+    EXPECT_EQ(statistics.misses, 0);
+
+    // The size class is empty now
+    void *third = pool.allocate(tileSize);
+    EXPECT_NE(third, second);
+    EXPECT_EQ(pool.getStatistics().misses, 1);
+    pool.release(second);
+    pool.release(third);
+}
+
+TEST(PixelBufferPoolTest, FreesTemporaryBuffers) {
+    PixelBufferPool pool;
+    void *temporary = pool.allocate(1000);
+    pool.release(temporary);
+    EXPECT_EQ(pool.getStatistics().idleBytes, 0);
+
+    void *pixels = pool.allocate(tileSize);
+    pool.recycle(pixels);
+    EXPECT_EQ(pool.getStatistics().idleBytes, tileSize);
+}
+
+TEST(PixelBufferPoolTest, LimitsIdleMemory) {
+    PixelBufferPool pool(2 * tileSize);
+    void *buffers[3];
+    for (void *&buffer: buffers) {
+        buffer = pool.allocate(tileSize);
+    }
+    for (void *buffer: buffers) {
+        pool.recycle(buffer);
+    }
+    EXPECT_EQ(pool.getStatistics().idleBytes, 2 * tileSize);
+
+    pool.setMaxIdleBytes(tileSize);
+    EXPECT_EQ(pool.getStatistics().idleBytes, tileSize);
+}
+
+TEST(PixelBufferPoolTest, ReallocationKeepsTheContents) {
+    PixelBufferPool pool;
+    auto *buffer = static_cast<unsigned char *>(pool.allocate(16));
+    for (unsigned char i = 0; i < 16; i++) {
+        buffer[i] = i;
+    }
+    buffer = static_cast<unsigned char *>(pool.reallocate(buffer, 1024));
+    for (unsigned char i = 0; i < 16; i++) {
+        EXPECT_EQ(buffer[i], i);
+    }
+    pool.release(buffer);
+}
@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <set>
+#include <chrono>
+#include <memory>
+#include "gtest/gtest.h"
+#include "../src/resources/ResourceFetcher.h"
+
+static const std::vector<std::string> texturePaths = {
+        "textures/daymaps/level_4_2/day_0_0_4_2_16200_8100.png",
+        "textures/daymaps/level_4_2/day_1_1_4_2_16200_8100.png",
+        "textures/daymaps/level_4_2/day_2_0_4_2_16200_8100.png",
+        "textures/daymaps/level_4_2/day_3_1_4_2_16200_8100.png"
+};
+
+/**
+ * Runs frames until the given number of results is collected, giving up after a few seconds.
+ */
+static std::vector<TextureLoadResult> waitForResults(ResourceFetcher &fetcher, size_t numResults) {
+    std::vector<TextureLoadResult> results;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (results.size() < numResults && std::chrono::steady_clock::now() < deadline) {
+        fetcher.advanceFrame();
+        for (TextureLoadResult &result: fetcher.retrieveLoadedResources()) {
+            results.push_back(std::move(result));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return results;
+}
+
+TEST(ResourceFetcherTest, LoadsEachRequestedTextureOnce) {
+    ResourceFetcher fetcher(3);
+    ASSERT_EQ(fetcher.getNumWorkers(), 3);
+
+    for (const std::string &path: texturePaths) {
+        fetcher.request({path});
+    }
+    std::vector<TextureLoadResult> results = waitForResults(fetcher, texturePaths.size());
+
+    ASSERT_EQ(results.size(), texturePaths.size());
+    std::set<std::string> loadedPaths;
+    for (const TextureLoadResult &result: results) {
+        loadedPaths.insert(result.path);
+        EXPECT_EQ(result.width, 480);
+        EXPECT_EQ(result.height, 480);
+        EXPECT_EQ(result.channels, 3);
+        EXPECT_NE(result.data, nullptr);
+        EXPECT_EQ(result.numMipLevels, 9);
+        EXPECT_NE(result.mipLevels, nullptr);
+    }
+    EXPECT_EQ(loadedPaths, std::set<std::string>(texturePaths.begin(), texturePaths.end()));
+}
+
+TEST(ResourceFetcherTest, DispatchesWithoutWaitingForTheNextFrame) {
+    // A single worker has room for fewer requests than are made
+    ResourceFetcher fetcher(1);
+    for (const std::string &path: texturePaths) {
+        fetcher.request({path});
+    }
+
+    // Picking up the results hands the remaining requests over; no frame is started
+    std::vector<TextureLoadResult> results;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (results.size() < texturePaths.size() && std::chrono::steady_clock::now() < deadline) {
+        for (TextureLoadResult &result: fetcher.retrieveLoadedResources()) {
+            results.push_back(std::move(result));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(results.size(), texturePaths.size());
+    EXPECT_EQ(fetcher.getNumPendingRequests(), 0);
+}
+
+TEST(ResourceFetcherTest, InstancesDoNotShareResults) {
+    ResourceFetcher first(1);
+    ResourceFetcher second(2);
+
+    first.request({texturePaths[0]});
+    second.request({texturePaths[1]});
+    second.request({texturePaths[2]});
+
+    std::vector<TextureLoadResult> firstResults = waitForResults(first, 1);
+    std::vector<TextureLoadResult> secondResults = waitForResults(second, 2);
+    ASSERT_EQ(firstResults.size(), 1);
+    EXPECT_EQ(firstResults[0].path, texturePaths[0]);
+    EXPECT_EQ(secondResults.size(), 2);
+}
+
+/**
+ * Distinct paths of the test textures, so that none of the requests are merged.
+ */
+static std::vector<std::string> getDistinctPaths(size_t numPaths) {
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < numPaths; i++) {
+        std::string prefix;
+        for (size_t lap = 0; lap < i / texturePaths.size(); lap++) {
+            prefix += "./";
+        }
+        paths.push_back(prefix + texturePaths[i % texturePaths.size()]);
+    }
+    return paths;
+}
+
+TEST(ResourceFetcherTest, StopsWithPendingRequests) {
+    const std::vector<std::string> paths = getDistinctPaths(50);
+    using Clock = std::chrono::steady_clock;
+
+    // How long decoding all the requests takes. They are kept while waiting without being re-asserted.
+    Clock::time_point start = Clock::now();
+    {
+        ResourceFetcher fetcher(2, 1000000);
+        for (const std::string &path: paths) {
+            fetcher.request({path});
+        }
+        ASSERT_EQ(waitForResults(fetcher, paths.size()).size(), paths.size());
+    }
+    Clock::duration decodingTime = Clock::now() - start;
+
+    ResourceFetcher fetcher(2);
+    for (const std::string &path: paths) {
+        fetcher.request({path});
+    }
+    ASSERT_GT(fetcher.getNumPendingRequests(), 0);
+    fetcher.stop();
+    EXPECT_EQ(fetcher.getNumPendingRequests(), 0);
+    // Only the requests handed to the workers were decoded
+    EXPECT_LT(fetcher.retrieveLoadedResources().size(), paths.size());
+
+    // Requests made after stopping are ignored
+    fetcher.request({paths[0]});
+    EXPECT_EQ(fetcher.getNumPendingRequests(), 0);
+    EXPECT_TRUE(fetcher.retrieveLoadedResources().empty());
+
+    // The destructor does not wait for the pending requests either
+    auto queuedFetcher = std::make_unique<ResourceFetcher>(2);
+    for (const std::string &path: paths) {
+        queuedFetcher->request({path});
+    }
+    start = Clock::now();
+    queuedFetcher.reset();
+    EXPECT_LT(Clock::now() - start, decodingTime / 2);
+}
+
+TEST(ResourceFetcherTest, CancelsRequestsThatAreNotReasserted) {
+    const unsigned int maxRequestAge = 2;
+    const size_t numRequests = 40;
+    ResourceFetcher fetcher(1, maxRequestAge);
+    for (size_t i = 0; i < numRequests; i++) {
+        fetcher.request({"textures/missing_" + std::to_string(i) + ".png"});
+    }
+
+    std::set<std::string> cancelledPaths;
+    for (unsigned int frame = 0; frame <= maxRequestAge; frame++) {
+        EXPECT_TRUE(cancelledPaths.empty());
+        for (const std::string &path: fetcher.advanceFrame()) {
+            cancelledPaths.insert(path);
+        }
+    }
+    EXPECT_EQ(fetcher.getNumPendingRequests(), 0);
+    EXPECT_FALSE(fetcher.updatePriority("textures/missing_0.png", 1));
+
+    // Every request was either decoded or cancelled, never both
+    size_t numDecoded = numRequests - cancelledPaths.size();
+    std::vector<TextureLoadResult> results = waitForResults(fetcher, numDecoded);
+    EXPECT_EQ(results.size(), numDecoded);
+}
+
+TEST(ResourceFetcherTest, ReassertedRequestsAreKept) {
+    ResourceFetcher fetcher(1, 1);
+    // Keep the worker busy so that the following requests stay pending
+    for (const std::string &path: texturePaths) {
+        fetcher.request({path});
+    }
+    fetcher.request({"textures/missing.png"});
+
+    bool isPending = true;
+    for (int frame = 0; frame < 5 && isPending; frame++) {
+        std::vector<std::string> cancelledPaths = fetcher.advanceFrame();
+        EXPECT_EQ(std::count(cancelledPaths.begin(), cancelledPaths.end(), "textures/missing.png"), 0);
+        isPending = fetcher.updatePriority("textures/missing.png", 1);
+    }
+}
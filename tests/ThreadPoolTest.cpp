@@ -0,0 +1,35 @@
+#include <vector>
+#include <atomic>
+#include "gtest/gtest.h"
+#include "../src/threading/ThreadPool.h"
+
+TEST(ThreadPoolTest, CallsEachTaskExactlyOnce) {
+    for (unsigned int numThreads: {1u, 2u, 8u}) {
+        ThreadPool threadPool(numThreads);
+        ASSERT_EQ(threadPool.getNumThreads(), numThreads);
+
+        std::vector<std::atomic<int>> calls(1000);
+        threadPool.parallelFor(calls.size(), [&calls](size_t index) {
+            calls[index]++;
+        });
+        for (const auto &count: calls) {
+            EXPECT_EQ(count, 1);
+        }
+    }
+}
+
+TEST(ThreadPoolTest, RunsConsecutiveLoops) {
+    ThreadPool threadPool(4);
+    std::atomic<size_t> sum{0};
+    for (size_t loop = 0; loop < 100; loop++) {
+        threadPool.parallelFor(loop, [&sum](size_t index) {
+            sum += index;
+        });
+    }
+    // Sum of 0 + 1 + ... + (loop - 1) over all loops
+    size_t expectedSum = 0;
+    for (size_t loop = 0; loop < 100; loop++) {
+        expectedSum += loop * (loop - 1) / 2;
+    }
+    EXPECT_EQ(sum, expectedSum);
+}
@@ -1,8 +1,10 @@
 
-
 #include <memory>
+#include <algorithm>
+#include <array>
 #include "gtest/gtest.h"
 #include "../src/tesselation/TileMeshTesselator.h"
+#include "../src/tesselation/VertexCacheOptimizer.h"
 #include <glm/mat4x4.hpp> // glm::mat4
 
 class TileMeshTesselatorFixture : public ::testing::Test {
@@ -14,29 +16,128 @@ protected:
     std::unique_ptr<TileMeshTesselator> tesselator;
 };
 
+/**
+ * Returns the triangles as triples of vertex positions, each rotated to start with
+ * its smallest vertex so that the comparison keeps the winding.
+ */
+static std::vector<std::array<float, 9>> getSortedTriangles(const IndexedMesh &mesh) {
+    std::vector<std::array<float, 9>> triangles;
+    for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+        std::array<glm::vec3, 3> corners = {mesh.vertices[mesh.indices[i]],
+                                            mesh.vertices[mesh.indices[i + 1]],
+                                            mesh.vertices[mesh.indices[i + 2]]};
+        auto isSmaller = [](const glm::vec3 &a, const glm::vec3 &b) {
+            return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+        };
+        auto smallest = std::min_element(corners.begin(), corners.end(), isSmaller);
+        std::rotate(corners.begin(), smallest, corners.end());
+
+        std::array<float, 9> triangle{};
+        for (int corner = 0; corner < 3; corner++) {
+            triangle[corner * 3] = corners[corner].x;
+            triangle[corner * 3 + 1] = corners[corner].y;
+            triangle[corner * 3 + 2] = corners[corner].z;
+        }
+        triangles.push_back(triangle);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+static IndexedMesh generateRowMajorGrid(int width, int height) {
+    IndexedMesh mesh;
+    for (int y = 0; y <= height; y++) {
+        for (int x = 0; x <= width; x++) {
+            mesh.vertices.emplace_back(x / static_cast<float>(width), y / static_cast<float>(height), 0);
+        }
+    }
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            unsigned int vertex1 = y * (width + 1) + x;
+            unsigned int vertex3 = vertex1 + width + 1;
+            mesh.indices.insert(mesh.indices.end(), {vertex1, vertex1 + 1, vertex3});
+            mesh.indices.insert(mesh.indices.end(), {vertex1 + 1, vertex3 + 1, vertex3});
+        }
+    }
+    return mesh;
+}
+
 TEST_F(TileMeshTesselatorFixture, GeneratesTheCorrectResolution) {
     Resolution resolution(5, 4);
-    Ellipsoid ellipsoid = Ellipsoid::unitSphere();
     Tile tile(0, 90, 10, 10);
 
-//    Mesh_t mesh = tesselator->generate(resolution, ellipsoid, tile);
-//
-//    // Each square is made up of two triangles.
-//    int numTriangles = (resolution.getWidth() - 1) * (resolution.getHeight() - 1) * 2;
-//    int numVertices = numTriangles * 3;
-//
-//    ASSERT_EQ(mesh.size(), numVertices);
+    IndexedMesh mesh = tesselator->generate(resolution, tile);
+
+    // Each vertex of the grid is stored once and each square is made up of two triangles.
+    size_t numVertices = (resolution.getWidth() + 1) * (resolution.getHeight() + 1);
+    size_t numTriangles = resolution.getWidth() * resolution.getHeight() * 2;
+
+    ASSERT_EQ(mesh.vertices.size(), numVertices);
+    ASSERT_EQ(mesh.getNumTriangles(), numTriangles);
+    for (unsigned int index: mesh.indices) {
+        EXPECT_LT(index, numVertices);
+    }
 }
 
-TEST_F(TileMeshTesselatorFixture, PointsLieOnUnitSphere) {
+TEST_F(TileMeshTesselatorFixture, PointsLieWithinTheTile) {
     Resolution resolution(5, 4);
-    Ellipsoid ellipsoid = Ellipsoid::unitSphere();
     Tile tile(0, 90, 10, 10);
 
-//    Mesh_t mesh = tesselator->generate(resolution, ellipsoid, tile);
-//
-//    float expectedLength = 1.f;
-//    for (auto &vertex : mesh) {
-//        EXPECT_NEAR(glm::length(vertex), expectedLength, 0.00001);
-//    }
-}
\ No newline at end of file
+    IndexedMesh mesh = tesselator->generate(resolution, tile);
+
+    // Vertices are offsets within the tile in the [0, 1] range.
+    for (auto &vertex: mesh.vertices) {
+        EXPECT_GE(vertex.x, 0.f);
+        EXPECT_LE(vertex.x, 1.f);
+        EXPECT_GE(vertex.y, 0.f);
+        EXPECT_LE(vertex.y, 1.f);
+    }
+}
+
+TEST_F(TileMeshTesselatorFixture, ReorderingKeepsTrianglesAndTheirWinding) {
+    Resolution resolution(12, 7);
+    Tile tile(0, 90, 10, 10);
+
+    IndexedMesh mesh = tesselator->generate(resolution, tile);
+    IndexedMesh rowMajorMesh = generateRowMajorGrid(resolution.getWidth(), resolution.getHeight());
+
+    EXPECT_EQ(getSortedTriangles(mesh), getSortedTriangles(rowMajorMesh));
+}
+
+TEST_F(TileMeshTesselatorFixture, ReorderingReducesVertexCacheMisses) {
+    unsigned int cacheSize = TileMeshTesselator::vertexCacheSize;
+    IndexedMesh mesh = generateRowMajorGrid(32, 32);
+    double rowMajorRatio = VertexCacheOptimizer::computeAverageCacheMissRatio(
+            mesh.indices, mesh.vertices.size(), cacheSize);
+
+    VertexCacheOptimizer::optimize(mesh, cacheSize);
+    double optimizedRatio = VertexCacheOptimizer::computeAverageCacheMissRatio(
+            mesh.indices, mesh.vertices.size(), cacheSize);
+
+    EXPECT_LT(optimizedRatio, rowMajorRatio);
+    EXPECT_LT(optimizedRatio, 0.8);
+}
+
+TEST_F(TileMeshTesselatorFixture, PackedVerticesKeepTileEdges) {
+    Resolution resolution(7, 3);
+    Tile tile(0, 90, 10, 10);
+
+    IndexedMesh mesh = tesselator->generate(resolution, tile);
+    std::vector<t_tile_vertex> packedVertices = convertToTileVertices(mesh.vertices);
+
+    ASSERT_EQ(packedVertices.size(), mesh.vertices.size());
+    for (size_t i = 0; i < mesh.vertices.size(); i++) {
+        float longitude = packedVertices[i].longitude / 65535.f;
+        float latitude = packedVertices[i].latitude / 65535.f;
+        EXPECT_NEAR(longitude, mesh.vertices[i].x, 0.5f / 65535.f);
+        EXPECT_NEAR(latitude, mesh.vertices[i].y, 0.5f / 65535.f);
+
+        // Neighbouring tiles must meet without cracks
+        if (mesh.vertices[i].x == 0.f || mesh.vertices[i].x == 1.f) {
+            EXPECT_EQ(longitude, mesh.vertices[i].x);
+        }
+        if (mesh.vertices[i].y == 0.f || mesh.vertices[i].y == 1.f) {
+            EXPECT_EQ(latitude, mesh.vertices[i].y);
+        }
+    }
+}
@@ -0,0 +1,149 @@
+#include <vector>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include "gtest/gtest.h"
+#include "../src/textures/TilePack.h"
+#include "../src/textures/TextureAtlas.h"
+#include "../src/textures/MipChain.h"
+
+class TilePackFixture : public ::testing::Test {
+protected:
+    const std::string packPath = "tile_pack_test.pack";
+    static constexpr uint32_t tileWidth = 4;
+
+    /**
+     * Writes the 2x1 tiles of the coarse level and the 4x2 tiles of the fine level.
+     * The pixels of each tile are set to its index in the pack.
+     */
+    void SetUp() override {
+        TilePackWriter writer(packPath, 10);
+        ASSERT_TRUE(writer.isOpen());
+        unsigned char tileIndex = 0;
+        for (uint32_t xTiles: {4u, 2u}) {
+            uint32_t yTiles = xTiles / 2;
+            for (uint32_t x = 0; x < xTiles; x++) {
+                for (uint32_t y = 0; y < yTiles; y++) {
+                    std::vector<unsigned char> pixels(tileWidth * tileWidth * 3, tileIndex++);
+                    ASSERT_TRUE(writer.addTile(x, y, xTiles, yTiles, tileWidth, tileWidth, 3, pixels.data()));
+                }
+            }
+        }
+        ASSERT_TRUE(writer.finish());
+    }
+
+    void TearDown() override {
+        std::remove(packPath.c_str());
+    }
+};
+
+TEST_F(TilePackFixture, ReadsTheWrittenTiles) {
+    std::shared_ptr<const TilePack> pack = TilePack::open(packPath);
+    ASSERT_NE(pack, nullptr);
+    ASSERT_EQ(pack->getNumTiles(), 10);
+
+    for (unsigned int i = 0; i < pack->getNumTiles(); i++) {
+        const TilePackEntry &entry = pack->getEntry(i);
+        EXPECT_EQ(entry.width, tileWidth);
+        EXPECT_EQ(entry.channels, 3);
+        ASSERT_EQ(entry.numMipLevels, 3); // 4x4, 2x2, 1x1
+        EXPECT_EQ(entry.offset % 4096, 0);
+
+        // The box filter keeps uniform colors
+        for (int level = 0; level < 3; level++) {
+            const unsigned char *pixels = pack->getMipLevel(i, level);
+            size_t size = MipChain::getLevelSize(tileWidth, tileWidth, 3, level);
+            for (size_t pixel = 0; pixel < size; pixel++) {
+                ASSERT_EQ(pixels[pixel], i);
+            }
+        }
+    }
+}
+
+TEST_F(TilePackFixture, RejectsOtherFiles) {
+    std::FILE *file = std::fopen(packPath.c_str(), "wb");
+    std::fputs("not a tile pack", file);
+    std::fclose(file);
+    EXPECT_EQ(TilePack::open(packPath), nullptr);
+    EXPECT_EQ(TilePack::open("missing.pack"), nullptr);
+}
+
+/**
+ * Overwrites a field of the first entry of the index, which follows the 16 bytes of the header.
+ */
+template<typename T>
+static void overwriteFirstEntry(const std::string &path, size_t fieldOffset, T value) {
+    std::FILE *file = std::fopen(path.c_str(), "r+b");
+    ASSERT_NE(file, nullptr);
+    std::fseek(file, static_cast<long>(16 + fieldOffset), SEEK_SET);
+    std::fwrite(&value, sizeof(value), 1, file);
+    std::fclose(file);
+}
+
+TEST_F(TilePackFixture, RejectsCorruptedEntries) {
+    // A truncated mip chain
+    overwriteFirstEntry<uint64_t>(packPath, offsetof(TilePackEntry, size), 3);
+    EXPECT_EQ(TilePack::open(packPath), nullptr);
+
+    // More levels than a 4x4 tile has, although the size matches them
+    overwriteFirstEntry<uint64_t>(packPath, offsetof(TilePackEntry, size), (16 + 4 + 1 + 1) * 3);
+    overwriteFirstEntry<uint32_t>(packPath, offsetof(TilePackEntry, numMipLevels), 4);
+    EXPECT_EQ(TilePack::open(packPath), nullptr);
+
+    // The end of the payload overflows and wraps around into the file
+    overwriteFirstEntry<uint64_t>(packPath, offsetof(TilePackEntry, size), (16 + 4 + 1) * 3);
+    overwriteFirstEntry<uint32_t>(packPath, offsetof(TilePackEntry, numMipLevels), 3);
+    overwriteFirstEntry<uint64_t>(packPath, offsetof(TilePackEntry, offset), UINT64_MAX - 8);
+    EXPECT_EQ(TilePack::open(packPath), nullptr);
+}
+
+TEST_F(TilePackFixture, StoresCompressedMipChains) {
+    const std::string compressedPath = "tile_pack_test_bc4.pack";
+    {
+        TilePackWriter writer(compressedPath, 1, TextureCompression::BC4);
+        std::vector<unsigned char> pixels(8 * 8, 100);
+        // Height maps have a single channel
+        std::vector<unsigned char> rgbPixels(8 * 8 * 3, 100);
+        EXPECT_FALSE(writer.addTile(0, 0, 1, 1, 8, 8, 3, rgbPixels.data()));
+        ASSERT_TRUE(writer.addTile(0, 0, 1, 1, 8, 8, 1, pixels.data()));
+        ASSERT_TRUE(writer.finish());
+    }
+
+    std::shared_ptr<const TilePack> pack = TilePack::open(compressedPath);
+    std::remove(compressedPath.c_str());
+    ASSERT_NE(pack, nullptr);
+    EXPECT_EQ(pack->getCompression(), TextureCompression::BC4);
+    const TilePackEntry &entry = pack->getEntry(0);
+    ASSERT_EQ(entry.numMipLevels, 4);
+    // 2x2 blocks, then a single block for the 4x4, 2x2 and 1x1 levels
+    EXPECT_EQ(entry.size, (4 + 1 + 1 + 1) * 8);
+    const unsigned char *lastLevel = pack->getMipLevel(0, 3);
+    EXPECT_EQ(lastLevel - pack->getMipLevel(0, 0), (4 + 1 + 1) * 8);
+    EXPECT_EQ(lastLevel[0], 100);
+    EXPECT_EQ(lastLevel[1], 100);
+
+    // Raw packs are not compressed
+    EXPECT_EQ(TilePack::open(packPath)->getCompression(), TextureCompression::None);
+}
+
+TEST_F(TilePackFixture, AtlasRegistersTheLevelsOfThePack) {
+    TextureAtlas textureAtlas;
+    ASSERT_TRUE(textureAtlas.registerPack(packPath));
+    ASSERT_EQ(textureAtlas.getNumLevelsOfDetail(), 2);
+
+    Resolution coarseLevel = textureAtlas.getLevelDimensions(0);
+    EXPECT_EQ(coarseLevel.getWidth(), 2);
+    EXPECT_EQ(coarseLevel.getHeight(), 1);
+    Resolution fineLevel = textureAtlas.getLevelDimensions(1);
+    EXPECT_EQ(fineLevel.getWidth(), 4);
+    EXPECT_EQ(fineLevel.getHeight(), 2);
+
+    Tile tile(0, 90, 10, 10);
+    auto texture = textureAtlas.getTexture(0, tile);
+    ASSERT_NE(texture->getPack(), nullptr);
+    const TilePackEntry &entry = texture->getPack()->getEntry(texture->getPackTileIndex());
+    EXPECT_EQ(entry.xTiles, 2);
+    EXPECT_EQ(entry.xIndex, 1);
+    EXPECT_EQ(entry.yIndex, 0);
+    EXPECT_EQ(texture->getResolution().getWidth(), static_cast<int>(tileWidth));
+}
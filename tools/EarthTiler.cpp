@@ -0,0 +1,499 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#include <stb_image.h>
+#include "../src/textures/MipChain.h"
+#include "../src/textures/PixelData.h"
+#include "../src/textures/TilePack.h"
+
+/**
+ * Builds the tile pyramid of a texture layer from a single equirectangular image;
+ * a native replacement of tile_generator.py.
+ *
+ * Usage: earth_tiler <input image> <output folder> <output file name>
+ *                    [--min-level 2] [--max-level 3] [--threads N] [--pack [--compression none|bc1|bc4|bc7]]
+ *
+ * Level l has 2^l x 2^(l-1) tiles. Without --pack, the tiles are written as binary PNM
+ * files in the layout of tile_generator.py, which the texture atlas reads:
+ * {folder}/level_{xt}_{yt}/{name}_{x}_{y}_{xt}_{yt}_{width}_{height}_{size}.ppm (or .pgm).
+ * With --pack, the output folder is the path of a tile pack instead.
+ *
+ * The most detailed level is resampled from the source one strip of tiles at a time,
+ * and each coarser level is box-filtered from two strips of the level below it, so
+ * only a few strips are kept in memory. Binary PNM sources (P5, P6) are streamed row
+ * by row; other formats are decoded whole. Tiles are written or encoded on all cores.
+ */
+
+struct Options {
+    std::string inputPath;
+    std::string outputPath;
+    std::string name;
+    int minLevel = 2;
+    int maxLevel = 3;
+    unsigned int numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    bool isPackOutput = false;
+    TextureCompression compression = TextureCompression::None;
+};
+
+/**
+ * Gives access to the rows of the source image, from top to bottom.
+ */
+class SourceImage {
+private:
+    std::FILE *file = nullptr;
+    // The whole image if it is not streamed
+    PixelData pixels;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    // The two most recently read rows of a streamed image
+    std::vector<unsigned char> rows[2];
+    int nextRow = 0;
+
+    static bool readHeaderValue(std::FILE *file, int &value) {
+        int character = std::fgetc(file);
+        while (character == '#' || std::isspace(character)) {
+            if (character == '#') {
+                while (character != '\n' && character != EOF) {
+                    character = std::fgetc(file);
+                }
+            }
+            character = std::fgetc(file);
+        }
+        value = 0;
+        if (!std::isdigit(character)) {
+            return false;
+        }
+        while (std::isdigit(character)) {
+            value = value * 10 + (character - '0');
+            character = std::fgetc(file);
+        }
+        // A single whitespace character follows the value
+        return std::isspace(character);
+    }
+
+    bool openPnm(const std::string &path) {
+        file = std::fopen(path.c_str(), "rb");
+        if (file == nullptr) {
+            return false;
+        }
+        char magic[2];
+        int maxValue;
+        if (std::fread(magic, 1, 2, file) != 2 || magic[0] != 'P' || (magic[1] != '5' && magic[1] != '6') ||
+            !readHeaderValue(file, width) || !readHeaderValue(file, height) || !readHeaderValue(file, maxValue) ||
+            maxValue > 255) {
+            std::fclose(file);
+            file = nullptr;
+            return false;
+        }
+        channels = magic[1] == '5' ? 1 : 3;
+        for (std::vector<unsigned char> &row: rows) {
+            row.resize(static_cast<size_t>(width) * channels);
+        }
+        return true;
+    }
+
+public:
+    ~SourceImage() {
+        if (file != nullptr) {
+            std::fclose(file);
+        }
+    }
+
+    bool open(const std::string &path) {
+        if (openPnm(path)) {
+            return true;
+        }
+        std::printf("Not an 8-bit binary PNM file, decoding %s whole\n", path.c_str());
+        // The alpha channel is dropped, as the tiles are stored in PNM files or RGB textures
+        if (!stbi_info(path.c_str(), &width, &height, &channels)) {
+            return false;
+        }
+        channels = channels <= 2 ? 1 : 3;
+        pixels = PixelData(stbi_load(path.c_str(), &width, &height, nullptr, channels));
+        return pixels != nullptr;
+    }
+
+    /**
+     * The row must not precede the previously requested one by more than a row.
+     * @return Null if the file ends prematurely.
+     */
+    const unsigned char *getRow(int y) {
+        size_t rowSize = static_cast<size_t>(width) * channels;
+        if (pixels) {
+            return pixels.get() + y * rowSize;
+        }
+        assert(y >= nextRow - 2);
+        while (nextRow <= y) {
+            if (std::fread(rows[nextRow % 2].data(), 1, rowSize, file) != rowSize) {
+                return nullptr;
+            }
+            nextRow++;
+        }
+        return rows[y % 2].data();
+    }
+
+    [[nodiscard]] int getWidth() const {
+        return width;
+    }
+
+    [[nodiscard]] int getHeight() const {
+        return height;
+    }
+
+    [[nodiscard]] int getChannels() const {
+        return channels;
+    }
+};
+
+struct TileJob {
+    int xIndex;
+    int yIndex;
+    int xTiles;
+    int yTiles;
+    std::vector<unsigned char> pixels;
+};
+
+/**
+ * Passes the tiles from the thread building the pyramid to the threads writing them.
+ * The producer waits while the queue is full, which bounds the memory taken up by the tiles.
+ */
+class TileQueue {
+private:
+    std::deque<TileJob> jobs;
+    size_t capacity;
+    bool isClosed = false;
+    std::mutex mutex;
+    std::condition_variable changed;
+
+public:
+    explicit TileQueue(size_t capacity) : capacity(capacity) {
+    }
+
+    void push(TileJob job) {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this] { return jobs.size() < capacity; });
+        jobs.push_back(std::move(job));
+        changed.notify_all();
+    }
+
+    /**
+     * @return False once the queue is closed and empty.
+     */
+    bool pop(TileJob &job) {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this] { return !jobs.empty() || isClosed; });
+        if (jobs.empty()) {
+            return false;
+        }
+        job = std::move(jobs.front());
+        jobs.pop_front();
+        changed.notify_all();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        isClosed = true;
+        changed.notify_all();
+    }
+};
+
+/**
+ * Builds the levels from the most detailed one to the coarsest one, a strip of tiles at a time.
+ */
+class PyramidBuilder {
+private:
+    struct Level {
+        int xTiles;
+        int yTiles;
+        // Two strips of tiles on top of each other; the coarser level is computed from both
+        std::vector<unsigned char> strips;
+    };
+
+    SourceImage &source;
+    TileQueue &queue;
+    int minLevel;
+    int maxLevel;
+    int tileSize;
+    int channels;
+    std::vector<Level> levels;
+
+    struct ColumnSample {
+        int left;
+        int right;
+        // The weight of the right pixel, out of 256
+        int weight;
+    };
+    std::vector<ColumnSample> columns;
+
+    [[nodiscard]] size_t getStripSize(const Level &level) const {
+        return static_cast<size_t>(level.xTiles) * tileSize * tileSize * channels;
+    }
+
+    /**
+     * Bilinearly resamples the source into a strip of the most detailed level.
+     */
+    bool resampleStrip(int tileRow, unsigned char *strip) {
+        const Level &level = levels[maxLevel];
+        int width = level.xTiles * tileSize;
+        int height = level.yTiles * tileSize;
+        double scale = static_cast<double>(source.getHeight()) / height;
+
+        for (int row = 0; row < tileSize; row++) {
+            int y = tileRow * tileSize + row;
+            double sourceY = std::clamp((y + 0.5) * scale - 0.5, 0.0, source.getHeight() - 1.0);
+            int top = static_cast<int>(sourceY);
+            int bottom = std::min(top + 1, source.getHeight() - 1);
+            int weight = static_cast<int>(std::lround((sourceY - top) * 256));
+            const unsigned char *topRow = source.getRow(top);
+            const unsigned char *bottomRow = source.getRow(bottom);
+            if (topRow == nullptr || bottomRow == nullptr) {
+                return false;
+            }
+
+            unsigned char *destination = strip + static_cast<size_t>(row) * width * channels;
+            for (int x = 0; x < width; x++) {
+                const ColumnSample &column = columns[x];
+                for (int channel = 0; channel < channels; channel++) {
+                    int left = column.left * channels + channel;
+                    int right = column.right * channels + channel;
+                    int upper = topRow[left] * (256 - column.weight) + topRow[right] * column.weight;
+                    int lower = bottomRow[left] * (256 - column.weight) + bottomRow[right] * column.weight;
+                    destination[x * channels + channel] =
+                            static_cast<unsigned char>((upper * (256 - weight) + lower * weight + 32768) >> 16);
+                }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Queues the tiles of a finished strip and continues with the coarser level
+     * once both of its source strips are there.
+     */
+    void finishStrip(int levelIndex, int tileRow) {
+        Level &level = levels[levelIndex];
+        const unsigned char *strip = level.strips.data() + (tileRow % 2) * getStripSize(level);
+        size_t stripStride = static_cast<size_t>(level.xTiles) * tileSize * channels;
+        size_t tileStride = static_cast<size_t>(tileSize) * channels;
+
+        for (int x = 0; x < level.xTiles; x++) {
+            TileJob job{x, tileRow, level.xTiles, level.yTiles,
+                        std::vector<unsigned char>(tileStride * tileSize)};
+            for (int row = 0; row < tileSize; row++) {
+                std::memcpy(job.pixels.data() + row * tileStride, strip + row * stripStride + x * tileStride,
+                            tileStride);
+            }
+            queue.push(std::move(job));
+        }
+
+        if (levelIndex > minLevel && tileRow % 2 == 1) {
+            Level &coarser = levels[levelIndex - 1];
+            int coarserRow = tileRow / 2;
+            MipChain::downsample(level.strips.data(), level.xTiles * tileSize, 2 * tileSize, channels,
+                                 coarser.strips.data() + (coarserRow % 2) * getStripSize(coarser));
+            finishStrip(levelIndex - 1, coarserRow);
+        }
+    }
+
+public:
+    PyramidBuilder(SourceImage &source, TileQueue &queue, int minLevel, int maxLevel, int tileSize)
+            : source(source), queue(queue), minLevel(minLevel), maxLevel(maxLevel), tileSize(tileSize),
+              channels(source.getChannels()), levels(maxLevel + 1) {
+        for (int levelIndex = minLevel; levelIndex <= maxLevel; levelIndex++) {
+            Level &level = levels[levelIndex];
+            level.xTiles = 1 << levelIndex;
+            level.yTiles = 1 << (levelIndex - 1);
+            level.strips.resize(2 * getStripSize(level));
+        }
+
+        int width = levels[maxLevel].xTiles * tileSize;
+        double scale = static_cast<double>(source.getWidth()) / width;
+        for (int x = 0; x < width; x++) {
+            double sourceX = std::clamp((x + 0.5) * scale - 0.5, 0.0, source.getWidth() - 1.0);
+            int left = static_cast<int>(sourceX);
+            columns.push_back({left, std::min(left + 1, source.getWidth() - 1),
+                               static_cast<int>(std::lround((sourceX - left) * 256))});
+        }
+    }
+
+    bool build() {
+        Level &finest = levels[maxLevel];
+        for (int tileRow = 0; tileRow < finest.yTiles; tileRow++) {
+            if (!resampleStrip(tileRow, finest.strips.data() + (tileRow % 2) * getStripSize(finest))) {
+                return false;
+            }
+            finishStrip(maxLevel, tileRow);
+        }
+        return true;
+    }
+
+    /**
+     * The number of tiles of all levels.
+     */
+    [[nodiscard]] unsigned int getNumTiles() const {
+        unsigned int numTiles = 0;
+        for (int levelIndex = minLevel; levelIndex <= maxLevel; levelIndex++) {
+            numTiles += levels[levelIndex].xTiles * levels[levelIndex].yTiles;
+        }
+        return numTiles;
+    }
+};
+
+static bool writePnm(const std::string &path, int width, int height, int channels, const unsigned char *pixels) {
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    size_t size = static_cast<size_t>(width) * height * channels;
+    bool isWritten = std::fprintf(file, "P%d\n%d %d\n255\n", channels == 1 ? 5 : 6, width, height) > 0 &&
+                     std::fwrite(pixels, 1, size, file) == size;
+    return std::fclose(file) == 0 && isWritten;
+}
+
+static bool parseOptions(int argc, char **argv, Options &options) {
+    std::vector<std::string> positional;
+    bool isCompressionSet = false;
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (argument == "--min-level" && hasValue) {
+            options.minLevel = std::atoi(argv[++i]);
+        } else if (argument == "--max-level" && hasValue) {
+            options.maxLevel = std::atoi(argv[++i]);
+        } else if (argument == "--threads" && hasValue) {
+            options.numThreads = std::max(std::atoi(argv[++i]), 1);
+        } else if (argument == "--pack") {
+            options.isPackOutput = true;
+        } else if (argument == "--compression" && hasValue) {
+            if (!BlockCompression::parseCompression(argv[++i], options.compression)) {
+                return false;
+            }
+            isCompressionSet = true;
+        } else {
+            positional.push_back(argument);
+        }
+    }
+    if (positional.size() != 3 || options.minLevel < 1 || options.minLevel > options.maxLevel ||
+        options.maxLevel > 12) {
+        return false;
+    }
+    // Image files are never compressed
+    if (isCompressionSet && !options.isPackOutput) {
+        std::fprintf(stderr, "--compression requires --pack\n");
+        return false;
+    }
+    options.inputPath = positional[0];
+    options.outputPath = positional[1];
+    options.name = positional[2];
+    return true;
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s <input image> <output folder> <output file name> [--min-level 2] "
+                             "[--max-level 3] [--threads N] [--pack [--compression none|bc1|bc4|bc7]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    SourceImage source;
+    if (!source.open(options.inputPath)) {
+        std::fprintf(stderr, "Failed to load %s\n", options.inputPath.c_str());
+        return EXIT_FAILURE;
+    }
+    int channels = source.getChannels();
+    // Rather than failing on the first tile
+    if (!BlockCompression::isCompatible(options.compression, channels)) {
+        std::fprintf(stderr, "The requested compression does not support the channels of %s\n",
+                     options.inputPath.c_str());
+        return EXIT_FAILURE;
+    }
+    // As in tile_generator.py, the tiles of all levels have the size of the most detailed ones
+    int tileSize = (source.getWidth() + (1 << options.maxLevel) - 1) >> options.maxLevel;
+
+    TileQueue queue(2 * options.numThreads);
+    PyramidBuilder builder(source, queue, options.minLevel, options.maxLevel, tileSize);
+
+    std::unique_ptr<TilePackWriter> packWriter;
+    if (options.isPackOutput) {
+        packWriter = std::make_unique<TilePackWriter>(options.outputPath, builder.getNumTiles(),
+                                                      options.compression);
+        if (!packWriter->isOpen()) {
+            return EXIT_FAILURE;
+        }
+    } else {
+        mkdir(options.outputPath.c_str(), 0755);
+        for (int level = options.minLevel; level <= options.maxLevel; level++) {
+            std::string levelPath = options.outputPath + "/level_" + std::to_string(1 << level) + "_" +
+                                    std::to_string(1 << (level - 1));
+            mkdir(levelPath.c_str(), 0755);
+        }
+    }
+
+    std::mutex packMutex;
+    std::atomic<unsigned int> numWritten{0};
+    std::atomic<bool> isFailed{false};
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < options.numThreads; i++) {
+        workers.emplace_back([&] {
+            TileJob job;
+            while (queue.pop(job)) {
+                bool isWritten;
+                if (packWriter != nullptr) {
+                    // Encoding is the expensive part and runs in parallel; only the writes are serialized
+                    std::vector<unsigned char> chain = TilePackWriter::encodeTile(
+                            options.compression, tileSize, tileSize, channels, job.pixels.data());
+                    std::lock_guard<std::mutex> lock(packMutex);
+                    isWritten = packWriter->addEncodedTile(job.xIndex, job.yIndex, job.xTiles, job.yTiles,
+                                                           tileSize, tileSize, channels, chain);
+                } else {
+                    std::string path = options.outputPath + "/level_" + std::to_string(job.xTiles) + "_" +
+                                       std::to_string(job.yTiles) + "/" + options.name + "_" +
+                                       std::to_string(job.xIndex) + "_" + std::to_string(job.yIndex) + "_" +
+                                       std::to_string(job.xTiles) + "_" + std::to_string(job.yTiles) + "_" +
+                                       std::to_string(source.getWidth()) + "_" +
+                                       std::to_string(source.getHeight()) + "_" + std::to_string(tileSize) +
+                                       (channels == 1 ? ".pgm" : ".ppm");
+                    isWritten = writePnm(path, tileSize, tileSize, channels, job.pixels.data());
+                }
+                if (isWritten) {
+                    numWritten++;
+                } else {
+                    isFailed = true;
+                }
+            }
+        });
+    }
+
+    bool isBuilt = builder.build();
+    queue.close();
+    for (std::thread &worker: workers) {
+        worker.join();
+    }
+    if (!isBuilt || isFailed || (packWriter != nullptr && !packWriter->finish())) {
+        std::fprintf(stderr, "Failed to build the tiles of %s\n", options.inputPath.c_str());
+        return EXIT_FAILURE;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("Written %u tiles of %dx%d pixels into %s in %.1f s (%u threads)\n", numWritten.load(),
+                tileSize, tileSize, options.outputPath.c_str(), seconds, options.numThreads);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <stb_image.h>
+#include "../src/textures/TextureAtlas.h"
+#include "../src/textures/TilePack.h"
+
+/**
+ * Converts a directory tree of texture tiles (one subdirectory per level, as produced
+ * by tile_generator.py) into a tile pack that TextureAtlas::registerPack can load.
+ *
+ * Usage: tile_pack_builder [--compression none|bc1|bc4|bc7] <layer directory> <output pack>
+ * For example: tile_pack_builder --compression bc1 textures/daymaps textures/daymaps.pack
+ *
+ * Compressed packs are uploaded as they are, taking 4-8 times less video memory.
+ * BC1 and BC7 suit the day and night maps, BC4 the single-channel height maps.
+ */
+
+struct TileFile {
+    std::string path;
+    TextureFileName name;
+};
+
+static std::vector<std::string> listDirectory(const std::string &path, bool directories) {
+    std::vector<std::string> entries;
+    DIR *directory = opendir(path.c_str());
+    if (!directory) {
+        return entries;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(directory))) {
+        std::string name = entry->d_name;
+        bool isDirectory = entry->d_type == DT_DIR;
+        if (name != "." && name != ".." && isDirectory == directories) {
+            entries.push_back(name);
+        }
+    }
+    closedir(directory);
+    return entries;
+}
+
+static std::vector<TileFile> findTileFiles(const std::string &layerPath) {
+    std::vector<TileFile> tileFiles;
+    for (const std::string &levelDirectory: listDirectory(layerPath, true)) {
+        std::string levelPath = layerPath + "/" + levelDirectory;
+        for (const std::string &fileName: listDirectory(levelPath, false)) {
+            TileFile tileFile{levelPath + "/" + fileName, {}};
+            if (TextureAtlas::parseTextureFileName(fileName, tileFile.name)) {
+                tileFiles.push_back(std::move(tileFile));
+            }
+        }
+    }
+    return tileFiles;
+}
+
+int main(int argc, char **argv) {
+    TextureCompression compression = TextureCompression::None;
+    int argument = 1;
+    if (argc == 5 && std::string(argv[1]) == "--compression") {
+        if (!BlockCompression::parseCompression(argv[2], compression)) {
+            std::fprintf(stderr, "Unknown compression: %s\n", argv[2]);
+            return EXIT_FAILURE;
+        }
+        argument = 3;
+    } else if (argc != 3) {
+        std::fprintf(stderr, "Usage: %s [--compression none|bc1|bc4|bc7] <layer directory> <output pack>\n",
+                     argv[0]);
+        return EXIT_FAILURE;
+    }
+    std::string layerPath = argv[argument];
+    std::string packPath = argv[argument + 1];
+
+    std::vector<TileFile> tileFiles = findTileFiles(layerPath);
+    if (tileFiles.empty()) {
+        std::fprintf(stderr, "No tiles found in %s\n", layerPath.c_str());
+        return EXIT_FAILURE;
+    }
+
+    TilePackWriter writer(packPath, tileFiles.size(), compression);
+    if (!writer.isOpen()) {
+        return EXIT_FAILURE;
+    }
+    for (size_t i = 0; i < tileFiles.size(); i++) {
+        const TileFile &tileFile = tileFiles[i];
+        int width, height, channels;
+        PixelData pixels(stbi_load(tileFile.path.c_str(), &width, &height, &channels, 0));
+        if (!pixels) {
+            std::fprintf(stderr, "Failed to load %s\n", tileFile.path.c_str());
+            return EXIT_FAILURE;
+        }
+
+        const TextureFileName &name = tileFile.name;
+        bool isAdded = writer.addTile(name.xIndex, name.yIndex, name.xTiles, name.yTiles,
+                                      width, height, channels, pixels.get());
+        if (!isAdded) {
+            std::fprintf(stderr, "Failed to write %s into the pack\n", tileFile.path.c_str());
+            return EXIT_FAILURE;
+        }
+        std::printf("\r%zu/%zu tiles", i + 1, tileFiles.size());
+        std::fflush(stdout);
+    }
+
+    if (!writer.finish()) {
+        std::fprintf(stderr, "\nFailed to write %s\n", packPath.c_str());
+        return EXIT_FAILURE;
+    }
+    std::printf("\nWritten %s\n", packPath.c_str());
+    return EXIT_SUCCESS;
+}